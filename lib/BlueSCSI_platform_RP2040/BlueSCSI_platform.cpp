@@ -666,6 +666,10 @@ void platform_poll()
 #ifdef ENABLE_AUDIO_OUTPUT
     audio_poll();
 #endif
+
+#ifdef BLUESCSI_NETWORK
+    platform_network_receive_poll();
+#endif
 }
 
 uint8_t platform_get_buttons() {return 0;}
@@ -4,6 +4,9 @@
 
 #include <stdint.h>
 #include <Arduino.h>
+#include <hardware/sync.h>
+#include <hardware/structs/timer.h>
+#include <hardware/regs/addressmap.h>
 #include "BlueSCSI_platform_gpio.h"
 #include "scsiHostPhy.h"
 
@@ -56,6 +59,31 @@ static inline void delay_100ns()
     asm volatile ("nop \n nop \n nop \n nop \n nop \n nop \n nop \n nop \n nop \n nop \n nop");
 }
 
+// Free-running 1 MHz timer for event timestamps, wraps every 71 minutes.
+// Can be called from interrupt mode.
+static inline uint32_t platform_time_us()
+{
+    return timer_hw->timerawl;
+}
+
+// Short critical section that is safe to nest inside interrupt handlers
+static inline uint32_t platform_irq_save()
+{
+    return save_and_disable_interrupts();
+}
+
+static inline void platform_irq_restore(uint32_t status)
+{
+    restore_interrupts(status);
+}
+
+// Check if pointer refers to flash, where string literals stay valid
+// for the lifetime of the firmware.
+static inline bool platform_is_rom_pointer(const void *p)
+{
+    return ((uint32_t)p >> 24) == (XIP_BASE >> 24);
+}
+
 // Initialize SD card and GPIO configuration
 void platform_init();
 
@@ -119,6 +147,12 @@ bool platform_read_romdrive(uint8_t *dest, uint32_t start, uint32_t count);
 bool platform_write_romdrive(const uint8_t *data, uint32_t start, uint32_t count);
 #endif
 
+// CRC-32 calculated by the DMA sniffer while copying, used by crc32_copy()
+#ifndef RP2040_DISABLE_CRC32_DMA
+#define PLATFORM_HAS_CRC32_COPY 1
+uint32_t platform_crc32_copy(void *dst, const void *src, uint32_t len);
+#endif
+
 // Parity lookup tables for write and read from SCSI bus.
 // These are used by macros below and the code in scsi_accel_rp2040.cpp
 extern const uint16_t g_scsi_parity_lookup[256];
@@ -127,7 +161,9 @@ extern const uint16_t g_scsi_parity_check_lookup[512];
 // Network functions
 bool platform_network_supported();
 void platform_network_poll();
+void platform_network_receive_poll();
 int platform_network_init(char *mac);
+const uint8_t *platform_network_mac();
 void platform_network_add_multicast_address(uint8_t *mac);
 bool platform_network_wifi_join(char *ssid, char *password);
 int platform_network_wifi_start_scan();
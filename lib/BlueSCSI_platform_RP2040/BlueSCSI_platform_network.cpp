@@ -35,6 +35,12 @@ static const char defaultMAC[] = { 0x00, 0x80, 0x19, 0xc0, 0xff, 0xee };
 
 static bool network_in_use = false;
 
+struct platform_network_counters g_platform_network_counters;
+
+#ifndef NETWORK_POLL_INTERVAL_US
+#define NETWORK_POLL_INTERVAL_US 500
+#endif
+
 bool __not_in_flash_func(platform_network_supported)()
 {
 	return rp2040.isPicoW();
@@ -94,6 +100,13 @@ int platform_network_init(char *mac)
 	return 0;
 }
 
+// MAC address the radio actually uses, which may differ from the
+// requested one if libpico uses the OTP MAC
+const uint8_t *platform_network_mac()
+{
+	return cyw43_state.mac;
+}
+
 void platform_network_add_multicast_address(uint8_t *mac)
 {
 	int ret;
@@ -134,11 +147,34 @@ void platform_network_poll()
 	cyw43_arch_poll();
 }
 
+// Called from platform_poll(), which also runs while the main loop is busy
+// in a long disk transfer, so that received frames keep going to the
+// inbound queue. Sending is left to platform_network_poll().
+void platform_network_receive_poll()
+{
+	static uint32_t last_poll;
+
+	if (!network_in_use)
+		return;
+
+	uint32_t now = platform_time_us();
+	if (now - last_poll < NETWORK_POLL_INTERVAL_US)
+		return;
+
+	last_poll = now;
+	cyw43_arch_poll();
+}
+
 int platform_network_send(uint8_t *buf, size_t len)
 {
+	// failures are retried by scsiNetworkPurge(), only log them when debugging
 	int ret = cyw43_send_ethernet(&cyw43_state, 0, len, buf, 0);
 	if (ret != 0)
-		log_f("cyw43_send_ethernet failed: %d", ret);
+	{
+		g_platform_network_counters.tx_errors++;
+		if (g_log_debug)
+			log_f("cyw43_send_ethernet failed: %d", ret);
+	}
 
 	return ret;
 }
@@ -291,6 +327,7 @@ int platform_network_wifi_channel()
 
 void cyw43_cb_process_ethernet(void *cb_data, int itf, size_t len, const uint8_t *buf)
 {
+	g_platform_network_counters.rx_frames++;
 	scsiNetworkEnqueue(buf, len);
 }
 
@@ -19,6 +19,7 @@
 
 #include <SdFat.h>
 #include <stdbool.h>
+#include <string.h>
 #include <hardware/dma.h>
 #include <hardware/irq.h>
 #include <hardware/spi.h>
@@ -28,6 +29,10 @@
 #include "BlueSCSI_config.h"
 #include "BlueSCSI_log.h"
 #include "BlueSCSI_platform.h"
+#include <scsi2sd.h>
+extern "C" {
+#include <scsi.h>
+}
 
 extern SdFs SD;
 
@@ -111,18 +116,17 @@ const uint16_t z_preamble = 0xE8CC;
 static dma_channel_config snd_dma_a_cfg;
 static dma_channel_config snd_dma_b_cfg;
 
-// some chonky buffers to store audio samples
-static uint8_t sample_buf_a[AUDIO_BUFFER_SIZE];
-static uint8_t sample_buf_b[AUDIO_BUFFER_SIZE];
+// some chonky buffers to store audio samples, consumed in ring order
+static uint8_t sample_buf[AUDIO_BUFFER_COUNT][AUDIO_BUFFER_SIZE];
 
 // tracking for the state of the above buffers
 enum bufstate { STALE, FILLING, READY };
-static volatile bufstate sbufst_a = STALE;
-static volatile bufstate sbufst_b = STALE;
-enum bufselect { A, B };
-static bufselect sbufsel = A;
+static volatile bufstate sbufst[AUDIO_BUFFER_COUNT];
+static uint8_t sbufsel = 0; // buffer being played by Core1
+static uint8_t sbuffill = 0; // next buffer to be filled by audio_poll()
 static uint16_t sbufpos = 0;
 static uint8_t sbufswap = 0;
+static volatile uint32_t sbufplayed = 0; // sample chunks played since start
 
 // buffers for storing biphase patterns
 #define SAMPLE_CHUNK_SIZE 1024 // ~5.8ms
@@ -133,9 +137,13 @@ static uint16_t wire_buf_b[WIRE_BUFFER_SIZE];
 // tracking for audio playback
 static uint8_t audio_owner; // SCSI ID or 0xFF when idle
 static volatile bool audio_paused = false;
-static ImageBackingStore* audio_file;
-static uint64_t fpos;
-static uint32_t fleft;
+static ImageBackingStore audio_file; // private copy of the image handle
+static ImageBackingStore* audio_source; // used to detect ejects
+static uint64_t audio_start;
+static uint32_t fleft; // bytes left to play
+static uint64_t ffileleft; // bytes left in the current file
+static uint8_t fcarry[SD_SECTOR_SIZE]; // samples read ahead from a partially used sector
+static uint16_t fcarrylen;
 
 // historical playback status information
 static audio_status_code audio_last_status[8] = {ASC_NO_STATUS};
@@ -248,61 +256,147 @@ static void snd_encode(uint8_t* samples, uint16_t* wire_patterns, uint16_t len,
     }
 }
 
-// functions for passing to Core1
-static void snd_process_a() {
-    if (sbufsel == A) {
-        if (sbufst_a == READY) {
-            snd_encode(sample_buf_a + sbufpos, wire_buf_a, SAMPLE_CHUNK_SIZE, sbufswap);
-            sbufpos += SAMPLE_CHUNK_SIZE;
-            if (sbufpos >= AUDIO_BUFFER_SIZE) {
-                sbufsel = B;
-                sbufpos = 0;
-                sbufst_a = STALE;
-            }
-        } else {
-            snd_encode(NULL, wire_buf_a, SAMPLE_CHUNK_SIZE, sbufswap);
+// encode the next chunk from the current sample buffer, or silence on underrun
+static void snd_process(uint16_t* wire_buf) {
+    if (sbufst[sbufsel] == READY) {
+        snd_encode(sample_buf[sbufsel] + sbufpos, wire_buf, SAMPLE_CHUNK_SIZE, sbufswap);
+        sbufplayed++;
+        sbufpos += SAMPLE_CHUNK_SIZE;
+        if (sbufpos >= AUDIO_BUFFER_SIZE) {
+            sbufst[sbufsel] = STALE;
+            sbufsel = (sbufsel + 1) % AUDIO_BUFFER_COUNT;
+            sbufpos = 0;
         }
     } else {
-        if (sbufst_b == READY) {
-            snd_encode(sample_buf_b + sbufpos, wire_buf_a, SAMPLE_CHUNK_SIZE, sbufswap);
-            sbufpos += SAMPLE_CHUNK_SIZE;
-            if (sbufpos >= AUDIO_BUFFER_SIZE) {
-                sbufsel = A;
-                sbufpos = 0;
-                sbufst_b = STALE;
-            }
-        } else {
-            snd_encode(NULL, wire_buf_a, SAMPLE_CHUNK_SIZE, sbufswap);
-        }
+        snd_encode(NULL, wire_buf, SAMPLE_CHUNK_SIZE, sbufswap);
     }
 }
+
+// functions for passing to Core1
+static void snd_process_a() {
+    snd_process(wire_buf_a);
+}
 static void snd_process_b() {
-    // clone of above for the other wire buffer
-    if (sbufsel == A) {
-        if (sbufst_a == READY) {
-            snd_encode(sample_buf_a + sbufpos, wire_buf_b, SAMPLE_CHUNK_SIZE, sbufswap);
-            sbufpos += SAMPLE_CHUNK_SIZE;
-            if (sbufpos >= AUDIO_BUFFER_SIZE) {
-                sbufsel = B;
-                sbufpos = 0;
-                sbufst_a = STALE;
-            }
-        } else {
-            snd_encode(NULL, wire_buf_b, SAMPLE_CHUNK_SIZE, sbufswap);
+    snd_process(wire_buf_b);
+}
+
+static bool all_buffers_stale() {
+    for (int i = 0; i < AUDIO_BUFFER_COUNT; i++) {
+        if (sbufst[i] != STALE) return false;
+    }
+    return true;
+}
+
+static int ready_buffer_count() {
+    int count = 0;
+    for (int i = 0; i < AUDIO_BUFFER_COUNT; i++) {
+        if (sbufst[i] == READY) count++;
+    }
+    return count;
+}
+
+// Starts reading samples at the given offset of audio_file. Reads are kept in
+// whole SD sectors so that a contiguous image stays in raw access mode, so the
+// bytes of the first sector before the offset are dropped here instead of
+// being played.
+static bool seek_samples(uint64_t start) {
+    uint64_t len = audio_file.size();
+    if (start > len) return false;
+
+    uint64_t aligned = start & ~(uint64_t)(SD_SECTOR_SIZE - 1);
+    if (!audio_file.seek(aligned)) return false;
+    fcarrylen = 0;
+    if (aligned != start) {
+        uint32_t skip = start - aligned;
+        ssize_t got = audio_file.read(fcarry, SD_SECTOR_SIZE);
+        if (got < (ssize_t)skip) return false;
+        fcarrylen = got - skip;
+        memmove(fcarry, fcarry + skip, fcarrylen);
+    }
+    ffileleft = len - start;
+    return true;
+}
+
+// reads len bytes of samples from the current file, which must have them;
+// samples of a sector that do not fit are kept in fcarry for the next read
+static bool read_samples(uint8_t* buf, uint32_t len) {
+    bool ok = true;
+    uint32_t have = (fcarrylen < len) ? fcarrylen : len;
+    memcpy(buf, fcarry, have);
+    memmove(fcarry, fcarry + have, fcarrylen - have);
+    fcarrylen -= have;
+
+    uint32_t direct = (len - have) & ~(uint32_t)(SD_SECTOR_SIZE - 1);
+    if (direct > 0) {
+        ok = audio_file.read(buf + have, direct) == (ssize_t)direct;
+        have += direct;
+    }
+
+    if (have < len) {
+        uint32_t rest = len - have;
+        ssize_t got = audio_file.read(fcarry, SD_SECTOR_SIZE);
+        if (got < (ssize_t)rest) {
+            ok = false;
+            got = rest;
         }
-    } else {
-        if (sbufst_b == READY) {
-            snd_encode(sample_buf_b + sbufpos, wire_buf_b, SAMPLE_CHUNK_SIZE, sbufswap);
-            sbufpos += SAMPLE_CHUNK_SIZE;
-            if (sbufpos >= AUDIO_BUFFER_SIZE) {
-                sbufsel = A;
-                sbufpos = 0;
-                sbufst_b = STALE;
-            }
-        } else {
-            snd_encode(NULL, wire_buf_b, SAMPLE_CHUNK_SIZE, sbufswap);
+        memcpy(buf + have, fcarry, rest);
+        fcarrylen = got - rest;
+        memmove(fcarry, fcarry + rest, fcarrylen);
+    }
+    ffileleft -= len;
+    return ok;
+}
+
+// CD images may store each track in a file of its own, in which case
+// playback continues from the start of the next file
+static bool open_next_file() {
+    ImageBackingStore* next;
+    uint64_t start;
+    if (!cdromGetNextAudioFile(audio_owner, &next, &start)) return false;
+
+    // opening the file may have stopped playback to free a cache slot
+    if (!audio_is_active()) return false;
+
+    audio_source = next;
+    audio_file = *next;
+    if (!seek_samples(start)) {
+        log("Sample file failed seek to ", start);
+        return false;
+    }
+    return true;
+}
+
+// reads the next block of samples into the given buffer
+static bool fill_buffer(uint8_t idx) {
+    sbufst[idx] = FILLING;
+    uint8_t* audiobuf = sample_buf[idx];
+    bool ok = true;
+
+    uint32_t consumed = (fleft < AUDIO_BUFFER_SIZE) ? fleft : AUDIO_BUFFER_SIZE;
+    uint32_t have = 0;
+    while (have < consumed) {
+        if (ffileleft == 0 && !open_next_file()) {
+            // end of data, playback stops after this buffer
+            consumed = have;
+            fleft = have;
+            break;
         }
+
+        uint32_t len = consumed - have;
+        if (len > ffileleft) len = ffileleft;
+        if (!read_samples(audiobuf + have, len)) ok = false;
+        have += len;
+    }
+
+    // the tail past the requested end is silenced
+    if (consumed < AUDIO_BUFFER_SIZE) {
+        memset(audiobuf + consumed, 0, AUDIO_BUFFER_SIZE - consumed);
     }
+    fleft -= consumed;
+
+    sbufst[idx] = READY;
+    sbuffill = (idx + 1) % AUDIO_BUFFER_COUNT;
+    return ok;
 }
 
 // Allows execution on Core1 via function pointers. Each function can take
@@ -373,14 +467,14 @@ void audio_setup() {
 void audio_poll() {
     if (!audio_is_active()) return;
     if (audio_paused) return;
-    if (fleft == 0 && sbufst_a == STALE && sbufst_b == STALE) {
+    if (fleft == 0 && all_buffers_stale()) {
         // out of data and ready to stop
         audio_stop(audio_owner);
         return;
     } else if (fleft == 0) {
         // out of data to read but still working on remainder
         return;
-    } else if (!audio_file->isOpen()) {
+    } else if (!audio_source->isOpen()) {
         // closed elsewhere, maybe disk ejected?
         debuglog("------ Playback stop due to closed file");
         audio_stop(audio_owner);
@@ -388,41 +482,16 @@ void audio_poll() {
     }
 
     // are new audio samples needed from the memory card?
-    uint8_t* audiobuf;
-    if (sbufst_a == STALE) {
-        sbufst_a = FILLING;
-        audiobuf = sample_buf_a;
-    } else if (sbufst_b == STALE) {
-        sbufst_b = FILLING;
-        audiobuf = sample_buf_b;
-    } else {
-        // no data needed this time
-        return;
-    }
+    if (sbufst[sbuffill] != STALE) return;
+
+    // while a SCSI command is in progress only refill when the ring is
+    // running low, otherwise wait for the bus to go free
+    if (scsiDev.phase != BUS_FREE && ready_buffer_count() > AUDIO_BUFFER_COUNT / 2) return;
 
     platform_set_sd_callback(NULL, NULL);
-    uint16_t toRead = AUDIO_BUFFER_SIZE;
-    if (fleft < toRead) toRead = fleft;
-    if (audio_file->position() != fpos) {
-        // should be uncommon due to SCSI command restrictions on devices
-        // playing audio; if this is showing up in logs a different approach
-        // will be needed to avoid seek performance issues on FAT32 vols
-        debuglog("------ Audio seek required on ", audio_owner);
-        if (!audio_file->seek(fpos)) {
-            log("Audio error, unable to seek to ", fpos, ", ID:", audio_owner);
-        }
-    }
-    if (audio_file->read(audiobuf, toRead) != toRead) {
+    if (!fill_buffer(sbuffill)) {
         log("Audio sample data underrun");
     }
-    fpos += toRead;
-    fleft -= toRead;
-
-    if (sbufst_a == FILLING) {
-        sbufst_a = READY;
-    } else if (sbufst_b == FILLING) {
-        sbufst_b = READY;
-    }
 }
 
 bool audio_play(uint8_t owner, ImageBackingStore* img, uint64_t start, uint64_t end, bool swap) {
@@ -441,54 +510,58 @@ bool audio_play(uint8_t owner, ImageBackingStore* img, uint64_t start, uint64_t
         return false;
     }
     platform_set_sd_callback(NULL, NULL);
-    audio_file = img;
-    if (!audio_file->isOpen()) {
+    if (!img->isOpen()) {
         log("File not open for audio playback, ", owner);
         return false;
     }
-    uint64_t len = audio_file->size();
-    if (start > len) {
+    uint64_t len = img->size();
+    if (start >= len) {
         log("File playback request start (", start, ":", len, ") outside file bounds");
         return false;
     }
-    // truncate playback end to end of file
-    // we will not consider this to be an error at the moment
+    // playback past the end of file continues in the next track file of
+    // the CD image if there is one, otherwise it ends at the end of file
     if (end > len) {
-        debuglog("------ Truncate audio play request end ", end, " to file size ", len);
-        end = len;
+        debuglog("------ Audio play request end ", end, " is beyond file size ", len);
     }
+
+    // Playback uses its own copy of the handle so that SCSI reads from the
+    // same image do not move the file position under it.
+    audio_source = img;
+    audio_file = *img;
     fleft = end - start;
     if (fleft <= 2 * AUDIO_BUFFER_SIZE) {
         log("File playback request (", start, ":", end, ") too short");
         return false;
     }
 
-    // read in initial sample buffers
-    if (!audio_file->seek(start)) {
+    // read in initial sample buffers, rest of the ring fills from audio_poll()
+    if (!seek_samples(start)) {
         log("Sample file failed start seek to ", start);
         return false;
     }
-    if (audio_file->read(sample_buf_a, AUDIO_BUFFER_SIZE) != AUDIO_BUFFER_SIZE) {
-        log("File playback start returned fewer bytes than allowed");
-        return false;
+    audio_start = start;
+    for (int i = 0; i < AUDIO_BUFFER_COUNT; i++) {
+        sbufst[i] = STALE;
     }
-    if (audio_file->read(sample_buf_b, AUDIO_BUFFER_SIZE) != AUDIO_BUFFER_SIZE) {
+    // owner is needed already if the initial buffers reach the next file
+    audio_owner = owner & 7;
+    if (!fill_buffer(0) || !fill_buffer(1) || !audio_is_active()) {
         log("File playback start returned fewer bytes than allowed");
+        for (int i = 0; i < AUDIO_BUFFER_COUNT; i++) {
+            sbufst[i] = STALE;
+        }
+        audio_owner = 0xFF;
         return false;
     }
 
     // prepare initial tracking state
-    fpos = audio_file->position();
-    fleft -= AUDIO_BUFFER_SIZE * 2;
-    sbufsel = A;
+    sbufsel = 0;
     sbufpos = 0;
+    sbufplayed = 0;
     sbufswap = swap;
-    sbufst_a = READY;
-    sbufst_b = READY;
-    audio_owner = owner & 7;
     audio_last_status[audio_owner] = ASC_PLAYING;
     audio_paused = false;
-
     // prepare the wire buffers
     for (uint16_t i = 0; i < WIRE_BUFFER_SIZE; i++) {
         wire_buf_a[i] = 0;
@@ -524,6 +597,12 @@ bool audio_play(uint8_t owner, ImageBackingStore* img, uint64_t start, uint64_t
     return true;
 }
 
+bool audio_get_file_position(uint8_t id, uint64_t *pos) {
+    if (audio_owner != (id & 7)) return false;
+    *pos = audio_start + (uint64_t)sbufplayed * SAMPLE_CHUNK_SIZE;
+    return true;
+}
+
 bool audio_set_paused(uint8_t id, bool paused) {
     if (audio_owner != (id & 7)) return false;
     else if (audio_paused && paused) return false;
@@ -544,8 +623,9 @@ void audio_stop(uint8_t id) {
     // to help mute external hardware, send a bunch of '0' samples prior to
     // halting the datastream; easiest way to do this is invalidating the
     // sample buffers, same as if there was a sample data underrun
-    sbufst_a = STALE;
-    sbufst_b = STALE;
+    for (int i = 0; i < AUDIO_BUFFER_COUNT; i++) {
+        sbufst[i] = STALE;
+    }
 
     // then indicate that the streams should no longer chain to one another
     // and wait for them to shut down naturally
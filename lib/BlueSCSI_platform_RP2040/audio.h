@@ -24,10 +24,15 @@
 #define SOUND_DMA_CHA 6
 #define SOUND_DMA_CHB 7
 
-// size of the two audio sample buffers, in bytes
+// size of each audio sample buffer, in bytes
 // these must be divisible by 1024
 #define AUDIO_BUFFER_SIZE 8192 // ~46.44ms
 
+// number of sample buffers in the read-ahead ring, at least 2
+#ifndef AUDIO_BUFFER_COUNT
+#define AUDIO_BUFFER_COUNT 4 // ~185.8ms
+#endif
+
 /**
  * Handler for DMA interrupts
  *
@@ -55,7 +60,9 @@ bool audio_is_active();
 void audio_setup();
 
 /**
- * Called from platform_poll() to fill sample buffer(s) if needed.
+ * Called from platform_poll() to fill sample buffer(s) if needed. While a
+ * SCSI command is in progress refills are deferred until the ring is half
+ * empty, so most SD card reads for audio happen between commands.
  */
 void audio_poll();
 
@@ -0,0 +1,44 @@
+// CRC-32 calculation with the RP2040 DMA sniffer.
+//
+// The sniffer observes every byte the DMA channel transfers, so the data
+// is copied and checksummed in the same pass. CRC32R mode feeds the bits
+// of each byte LSB first and the result is bit reversed and inverted,
+// which gives the same reflected CRC-32 as the software version in crc32.c.
+
+#include <BlueSCSI_platform.h>
+#include <hardware/dma.h>
+#include <hardware/structs/dma.h>
+
+#ifndef RP2040_DISABLE_CRC32_DMA
+
+#define CRC32_DMA_CH 10
+
+extern "C" uint32_t __not_in_flash_func(platform_crc32_copy)(void *dst, const void *src, uint32_t len)
+{
+    static bool resources_claimed = false;
+    if (!resources_claimed)
+    {
+        dma_channel_claim(CRC32_DMA_CH);
+        resources_claimed = true;
+    }
+
+    // Byte transfers keep the sniffer input in memory order
+    dma_channel_config dmacfg = dma_channel_get_default_config(CRC32_DMA_CH);
+    channel_config_set_transfer_data_size(&dmacfg, DMA_SIZE_8);
+    channel_config_set_read_increment(&dmacfg, true);
+    channel_config_set_write_increment(&dmacfg, true);
+    channel_config_set_sniff_enable(&dmacfg, true);
+
+    dma_sniffer_enable(CRC32_DMA_CH, DMA_SNIFF_CTRL_CALC_VALUE_CRC32R, true);
+    hw_set_bits(&dma_hw->sniff_ctrl, DMA_SNIFF_CTRL_OUT_REV_BITS | DMA_SNIFF_CTRL_OUT_INV_BITS);
+    dma_hw->sniff_data = 0xFFFFFFFF;
+
+    dma_channel_configure(CRC32_DMA_CH, &dmacfg, dst, src, len, true);
+    dma_channel_wait_for_finish_blocking(CRC32_DMA_CH);
+
+    uint32_t crc = dma_hw->sniff_data;
+    dma_sniffer_disable();
+    return crc;
+}
+
+#endif
@@ -16,6 +16,12 @@ extern "C" {
 volatile int g_scsiHostPhyReset;
 bool perform_parity_checking = true;
 
+// Transfer mode negotiated with the currently selected target
+static struct {
+    int syncOffset;
+    int syncPeriod;
+} g_scsiHostSync;
+
 // Release bus and pulse RST signal, initialize PHY to host mode.
 void scsiHostPhyReset(void)
 {
@@ -23,6 +29,11 @@ void scsiHostPhyReset(void)
     SCSI_ENABLE_INITIATOR();
 
     scsi_accel_host_init();
+    scsiHostPhySetATN(false);
+
+    // Bus reset returns all targets to asynchronous mode
+    g_scsiHostSync.syncOffset = 0;
+    g_scsiHostSync.syncPeriod = 0;
 
     SCSI_OUT(RST, 1);
     delay(2);
@@ -89,6 +100,31 @@ bool scsiHostPhySelect(int target_id, int initiator_id)
     return true;
 }
 
+bool scsiHostPhyHasATN()
+{
+#ifdef SCSI_OUT_ATN
+    return true;
+#else
+    return false;
+#endif
+}
+
+void scsiHostPhySetATN(bool assert)
+{
+#ifdef SCSI_OUT_ATN
+    *(assert ? &sio_hw->gpio_clr : &sio_hw->gpio_set) = 1 << SCSI_OUT_ATN;
+    sio_hw->gpio_oe_set = 1 << SCSI_OUT_ATN;
+#else
+    (void)assert;
+#endif
+}
+
+void scsiHostPhySetSyncMode(int syncOffset, int syncPeriod)
+{
+    g_scsiHostSync.syncOffset = syncOffset;
+    g_scsiHostSync.syncPeriod = syncPeriod;
+}
+
 // Read the current communication phase as signaled by the target
 int scsiHostPhyGetPhase()
 {
@@ -221,12 +257,22 @@ uint32_t scsiHostRead(uint8_t *data, uint32_t count)
     int cd_start = SCSI_IN(CD);
     int msg_start = SCSI_IN(MSG);
 
-    if ((count & 1) == 0 && ((uint32_t)data & 1) == 0)
+    // Synchronous transfers are only used in DATA_IN phase,
+    // messages and status are always transferred asynchronously.
+    bool data_phase = !cd_start && !msg_start;
+    bool sync = data_phase && g_scsiHostSync.syncOffset > 0;
+
+    if (count > 1 || sync)
     {
-        // Even number of bytes, use accelerated routine
-        count = scsi_accel_host_read(data, count, &parityError, &parityResult, &g_scsiHostPhyReset);
+        // Use accelerated routine, which also checks parity through the lookup table
+        if (sync)
+            scsi_accel_host_setSyncMode(g_scsiHostSync.syncOffset, g_scsiHostSync.syncPeriod);
+        else
+            scsi_accel_host_setSyncMode(0, 0);
+
+        count = scsi_accel_host_read(data, count, &parityError, &g_scsiHostPhyReset);
         if (parityError && perform_parity_checking) {
-            log("Parity error in scsi_accel_host_read(): ", parityResult);
+            log("Parity error in scsi_accel_host_read()");
         } else {
             parityError = 0;
         }
@@ -241,8 +287,12 @@ uint32_t scsiHostRead(uint8_t *data, uint32_t count)
                 {
                     // Target switched out of DATA_IN mode
                     count = i;
+                    break;
                 }
             }
+
+            if (i >= count) break;
+
             data[i] = scsiHostReadOneByte(&parityError, &parityResult);
             if (parityError && perform_parity_checking) {
                 log("Parity error in scsiReadOneByte(): ", parityResult);
@@ -273,6 +323,7 @@ uint32_t scsiHostRead(uint8_t *data, uint32_t count)
 void scsiHostPhyRelease()
 {
     scsiLogInitiatorPhaseChange(BUS_FREE);
+    scsiHostPhySetATN(false);
     SCSI_RELEASE_OUTPUTS();
     SCSI_RELEASE_DATA_REQ();
 }
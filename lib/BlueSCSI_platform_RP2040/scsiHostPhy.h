@@ -16,6 +16,18 @@ void scsiHostPhyReset(void);
 // Returns true if the target answers to selection request.
 bool scsiHostPhySelect(int target_id, int initiator_id);
 
+// Returns true if the hardware can drive the ATN signal.
+// ATN is needed to request MESSAGE_OUT phase for synchronous transfer negotiation.
+bool scsiHostPhyHasATN();
+
+// Assert or release ATN signal, no-op if hardware does not have ATN output.
+void scsiHostPhySetATN(bool assert);
+
+// Set the transfer mode negotiated with the currently selected target.
+// Setting syncOffset = 0 selects asynchronous transfers.
+// The synchronous mode only applies to DATA_IN phase.
+void scsiHostPhySetSyncMode(int syncOffset, int syncPeriod);
+
 // Read the current communication phase as signaled by the target
 // Matches SCSI_PHASE enumeration from scsi.h.
 int scsiHostPhyGetPhase();
@@ -9,6 +9,8 @@
 #include "BlueSCSI_log.h"
 #include "BlueSCSI_log_trace.h"
 #include "BlueSCSI_config.h"
+#include "BlueSCSI_timeline.h"
+#include "BlueSCSI_stats.h"
 #include "scsi_accel_rp2040.h"
 #include "hardware/structs/iobank0.h"
 
@@ -63,6 +65,7 @@ void scsi_bsy_deassert_interrupt()
             // Set ATN flag here unconditionally, real value is only known after
             // OUT_BSY is enabled in scsiStatusSEL() below.
             g_scsi_sts_selection = SCSI_STS_SELECTION_SUCCEEDED | SCSI_STS_SELECTION_ATN | sel_id;
+            timeline_record(TIMELINE_EVT_SELECTION, sel_id, sel_bits);
         }
 
         // selFlag is required for Philips P2000C which releases it after 600ns
@@ -193,6 +196,12 @@ extern "C" uint32_t scsiEnterPhaseImmediate(int phase)
         int oldphase = g_scsi_phase;
         g_scsi_phase = (SCSI_PHASE)phase;
         scsiLogPhaseChange(phase);
+        timeline_record(TIMELINE_EVT_PHASE, (uint16_t)phase, 0);
+
+        if (phase == STATUS)
+        {
+            scsiStatsCommandEnd();
+        }
 
         // Select between synchronous vs. asynchronous SCSI writes
         bool syncstatus = false;
@@ -260,6 +269,11 @@ extern "C" uint32_t scsiEnterPhaseImmediate(int phase)
 // Release all signals
 void scsiEnterBusFree(void)
 {
+    if (g_scsi_phase != BUS_FREE)
+    {
+        timeline_record(TIMELINE_EVT_PHASE, (uint16_t)BUS_FREE, 0);
+    }
+
     g_scsi_phase = BUS_FREE;
     g_scsi_sts_selection = 0;
     g_scsi_ctrl_bsy = 0;
@@ -323,6 +337,7 @@ extern "C" void scsiWrite(const uint8_t* data, uint32_t count)
 extern "C" void scsiStartWrite(const uint8_t* data, uint32_t count)
 {
     scsiLogDataIn(data, count);
+    if (g_scsi_phase == DATA_IN) scsiStatsDataBytes(count);
     scsi_accel_rp2040_startWrite(data, count, &scsiDev.resetFlag);
 }
 
@@ -375,6 +390,7 @@ extern "C" void scsiRead(uint8_t* data, uint32_t count, int* parityError)
 
 extern "C" void scsiStartRead(uint8_t* data, uint32_t count, int *parityError)
 {
+    if (g_scsi_phase == DATA_OUT) scsiStatsDataBytes(count);
     scsi_accel_rp2040_startRead(data, count, parityError, &scsiDev.resetFlag);
 }
 
@@ -382,6 +398,13 @@ extern "C" void scsiFinishRead(uint8_t* data, uint32_t count, int *parityError)
 {
     scsi_accel_rp2040_finishRead(data, count, parityError, &scsiDev.resetFlag);
     scsiLogDataOut(data, count);
+
+    if (data == scsiDev.cdb)
+    {
+        scsiStatsCommandStart(data[0]);
+        timeline_record(TIMELINE_EVT_COMMAND, data[0],
+            ((uint32_t)data[2] << 24) | ((uint32_t)data[3] << 16) | ((uint32_t)data[4] << 8) | data[5]);
+    }
 }
 
 extern "C" bool scsiIsReadFinished(const uint8_t *data)
@@ -2,6 +2,17 @@
 // Copyright (c) 2022 Rabbit Hole Computing™
 // Copyright (c) 2024 Tech by Androda, LLC
 
+/* Data flow in SCSI host read acceleration:
+ *
+ * 1. scsi_host_read PIO answers every REQ from target with ACK and samples the data bus.
+ * 2. Each sample is turned into an address in g_scsi_parity_check_lookup.
+ * 3. DMA fetches the lookup entry and feeds it to scsi_host_read_parity PIO.
+ * 4. scsi_host_read_parity PIO flags parity errors and passes the data byte on.
+ * 5. DMA copies the data bytes to the application buffer.
+ *
+ * This is the same lookup chain that scsi_accel_rp2040.cpp uses on the target side.
+ */
+
 #include "scsi_accel_host.h"
 #include "BlueSCSI_platform.h"
 #include "BlueSCSI_log.h"
@@ -12,18 +23,45 @@
 #include <hardware/structs/iobank0.h>
 #include <hardware/sync.h>
 
+// The host mode uses the same PIO and DMA resources as target mode.
+// The two modes are never active at the same time.
 #define SCSI_PIO pio0
 #define SCSI_SM 1
+#define SCSI_PARITY_SM 2
+
+// SCSI bus read acceleration uses 3 DMA channels (data flow C->B->A):
+// A: Bytes from scsi_host_read_parity PIO to memory buffer
+// B: Lookup from g_scsi_parity_check_lookup and copy to scsi_host_read_parity PIO
+// C: Addresses from scsi_host_read PIO to lookup DMA READ_ADDR register
+#define SCSI_DMA_CH_A 6
+#define SCSI_DMA_CH_B 7
+#define SCSI_DMA_CH_C 8
+
+// Index of the REQ wait instruction in scsi_host_read, the delay of which
+// is rewritten by scsi_accel_host_setSyncMode().
+#define SCSI_HOST_READ_REQ_WAIT_INSTR 1
 
 static struct {
+    // Synchronous mode?
+    int syncOffset;
+    int syncPeriod;
+
     // PIO configurations
-    uint32_t pio_offset_async_read;
-    pio_sm_config pio_cfg_async_read;
+    uint32_t pio_offset_read;
+    uint32_t pio_offset_read_parity;
+    pio_sm_config pio_cfg_read;
+    pio_sm_config pio_cfg_read_parity;
+
+    // DMA configurations for read
+    dma_channel_config dmacfg_read_chA; // Data to destination memory buffer
+    dma_channel_config dmacfg_read_chB; // From lookup table to scsi_host_read_parity PIO
+    dma_channel_config dmacfg_read_chC; // From scsi_host_read to channel B READ_ADDR
 } g_scsi_host;
 
 enum scsidma_state_t { SCSIHOST_IDLE = 0,
                        SCSIHOST_READ };
 static volatile scsidma_state_t g_scsi_host_state;
+static bool g_host_channels_claimed = false;
 
 static void scsi_accel_host_config_gpio()
 {
@@ -66,81 +104,212 @@ static void scsi_accel_host_config_gpio()
     }
 }
 
-uint32_t scsi_accel_host_read(uint8_t *buf, uint32_t count, int *parityError, uint32_t *parityResult, volatile int *resetFlag)
+// Load the state machines with byte count and parity lookup table address.
+// Also sets up DMA channels B and C.
+static void config_sm_for_read(uint32_t count)
+{
+    // Configure parity check state machine
+    pio_sm_init(SCSI_PIO, SCSI_PARITY_SM, g_scsi_host.pio_offset_read_parity, &g_scsi_host.pio_cfg_read_parity);
+
+    // Load base address to state machine register Y and byte count to register X
+    uint32_t addrbase = (uint32_t)&g_scsi_parity_check_lookup[0];
+    assert((addrbase & 0x3FF) == 0);
+    pio_sm_init(SCSI_PIO, SCSI_SM, g_scsi_host.pio_offset_read, &g_scsi_host.pio_cfg_read);
+    pio_sm_put(SCSI_PIO, SCSI_SM, addrbase >> 10);
+    pio_sm_exec(SCSI_PIO, SCSI_SM, pio_encode_pull(false, false) | pio_encode_sideset(1, 1));
+    pio_sm_exec(SCSI_PIO, SCSI_SM, pio_encode_mov(pio_y, pio_osr) | pio_encode_sideset(1, 1));
+    pio_sm_put(SCSI_PIO, SCSI_SM, count - 1);
+    pio_sm_exec(SCSI_PIO, SCSI_SM, pio_encode_pull(false, false) | pio_encode_sideset(1, 1));
+    pio_sm_exec(SCSI_PIO, SCSI_SM, pio_encode_mov(pio_x, pio_osr) | pio_encode_sideset(1, 1));
+
+    // TX fifo is not needed after this, so join it to RX fifo to give
+    // more slack for the DMA chain in synchronous mode.
+    hw_set_bits(&SCSI_PIO->sm[SCSI_SM].shiftctrl, PIO_SM0_SHIFTCTRL_FJOIN_RX_BITS);
+
+    // DMA channel B will read g_scsi_parity_check_lookup and write to scsi_host_read_parity PIO.
+    dma_channel_configure(SCSI_DMA_CH_B,
+        &g_scsi_host.dmacfg_read_chB,
+        &SCSI_PIO->txf[SCSI_PARITY_SM],
+        NULL,
+        1, false);
+
+    // DMA channel C will copy addresses from data PIO to DMA channel B read address register.
+    // It is triggered by the data SM RX FIFO request.
+    // This triggers channel B by writing to READ_ADDR_TRIG
+    // Channel B chaining re-enables this channel.
+    dma_channel_configure(SCSI_DMA_CH_C,
+        &g_scsi_host.dmacfg_read_chC,
+        &dma_hw->ch[SCSI_DMA_CH_B].al3_read_addr_trig,
+        &SCSI_PIO->rxf[SCSI_SM],
+        1, true);
+
+    // Clear PIO IRQ flag that is used to detect parity error
+    SCSI_PIO->irq = 1;
+}
+
+// Check if all bytes that have been ACKed have made it through the DMA chain
+static bool scsi_accel_host_chain_idle()
 {
-    // Currently this method just reads from the PIO RX fifo directly in software loop.
-    // The SD card access is parallelized using DMA, so there is limited benefit from using DMA here.
+    return pio_sm_is_rx_fifo_empty(SCSI_PIO, SCSI_SM) &&
+           pio_sm_is_tx_fifo_empty(SCSI_PIO, SCSI_PARITY_SM) &&
+           pio_sm_is_rx_fifo_empty(SCSI_PIO, SCSI_PARITY_SM) &&
+           !dma_channel_is_busy(SCSI_DMA_CH_B);
+}
+
+static void scsi_accel_host_stopRead()
+{
+    dma_channel_abort(SCSI_DMA_CH_A);
+    dma_channel_abort(SCSI_DMA_CH_B);
+    dma_channel_abort(SCSI_DMA_CH_C);
+    g_scsi_host_state = SCSIHOST_IDLE;
+    SCSI_RELEASE_DATA_REQ();
+    scsi_accel_host_config_gpio();
+    pio_sm_set_enabled(SCSI_PIO, SCSI_SM, false);
+    pio_sm_set_enabled(SCSI_PIO, SCSI_PARITY_SM, false);
+}
+
+uint32_t scsi_accel_host_read(uint8_t *buf, uint32_t count, int *parityError, volatile int *resetFlag)
+{
+    if (count == 0) return 0;
+
     g_scsi_host_state = SCSIHOST_READ;
 
     int cd_start = SCSI_IN(CD);
     int msg_start = SCSI_IN(MSG);
 
-    pio_sm_init(SCSI_PIO, SCSI_SM, g_scsi_host.pio_offset_async_read, &g_scsi_host.pio_cfg_async_read);
+    config_sm_for_read(count);
+
+    // Start DMA to fill the destination buffer
+    dma_channel_configure(SCSI_DMA_CH_A,
+        &g_scsi_host.dmacfg_read_chA,
+        buf,
+        &SCSI_PIO->rxf[SCSI_PARITY_SM],
+        count,
+        true
+    );
+
     scsi_accel_host_config_gpio();
+    pio_sm_set_enabled(SCSI_PIO, SCSI_PARITY_SM, true);
     pio_sm_set_enabled(SCSI_PIO, SCSI_SM, true);
 
-    // Set the number of bytes to read, must be divisible by 2.
-    assert((count & 1) == 0);
-    pio_sm_put(SCSI_PIO, SCSI_SM, count - 1);
-
-    // Read results from PIO RX FIFO
-    uint8_t *dst = buf;
-    uint8_t *end = buf + count;
-    uint32_t paritycheck = 0;
-    while (dst < end)
+    while (dma_channel_is_busy(SCSI_DMA_CH_A))
     {
-        uint32_t available = pio_sm_get_rx_fifo_level(SCSI_PIO, SCSI_SM);
-
-        if (available == 0)
+        if (*resetFlag)
         {
-            if (*resetFlag || !SCSI_IN(IO) || SCSI_IN(CD) != cd_start || SCSI_IN(MSG) != msg_start)
-            {
-                // Target switched out of DATA_IN mode
-                count = dst - buf;
-                break;
-            }
+            break;
         }
 
-        while (available > 0)
+        if (!SCSI_IN(IO) || SCSI_IN(CD) != cd_start || SCSI_IN(MSG) != msg_start)
         {
-            available--;
-            uint32_t word = pio_sm_get(SCSI_PIO, SCSI_SM);
-            paritycheck ^= word;
-            word = ~word;
-            *dst++ = word & 0xFF;
-            *dst++ = word >> 16;
+            // Target switched out of DATA_IN mode.
+            // Wait for the bytes that were already ACKed to reach the buffer.
+            if (scsi_accel_host_chain_idle())
+            {
+                delay_100ns();
+                if (scsi_accel_host_chain_idle()) break;
+            }
         }
     }
 
-    // Check parity errors in whole block
-    // This doesn't detect if there is even number of parity errors in block.
-    uint8_t byte0 = ~(paritycheck & 0xFF);
-    uint8_t byte1 = ~(paritycheck >> 16);
-    if (paritycheck != ((g_scsi_parity_lookup[byte1] << 16) | g_scsi_parity_lookup[byte0]))
+    count -= dma_channel_hw_addr(SCSI_DMA_CH_A)->transfer_count;
+
+    // Check if any parity errors have been detected during the transfer
+    if (SCSI_PIO->irq & 1)
     {
         *parityError = 1;
-        *parityResult = paritycheck;
     }
 
-    g_scsi_host_state = SCSIHOST_IDLE;
-    SCSI_RELEASE_DATA_REQ();
-    scsi_accel_host_config_gpio();
-    pio_sm_set_enabled(SCSI_PIO, SCSI_SM, false);
+    scsi_accel_host_stopRead();
 
     return count;
 }
 
+void scsi_accel_host_setSyncMode(int syncOffset, int syncPeriod)
+{
+    if (syncOffset == g_scsi_host.syncOffset && syncPeriod == g_scsi_host.syncPeriod)
+    {
+        return;
+    }
+
+    g_scsi_host.syncOffset = syncOffset;
+    g_scsi_host.syncPeriod = syncPeriod;
+
+    // Asynchronous and slow synchronous transfers give the data bus time to settle
+    // after REQ goes low. Fast SCSI only guarantees 10 ns hold time, so sample right away.
+    int delay = (syncOffset > 0 && syncPeriod <= 25) ? 0 : 1;
+    uint16_t instr = (scsi_host_read_program_instructions[SCSI_HOST_READ_REQ_WAIT_INSTR] & ~0x0F00) | pio_encode_delay(delay);
+    SCSI_PIO->instr_mem[g_scsi_host.pio_offset_read + SCSI_HOST_READ_REQ_WAIT_INSTR] = instr;
+}
 
 void scsi_accel_host_init()
 {
     g_scsi_host_state = SCSIHOST_IDLE;
     scsi_accel_host_config_gpio();
 
+    if (g_host_channels_claimed)
+    {
+        // Remove programs from previous bus reset, they will be reloaded below
+        pio_remove_program(SCSI_PIO, &scsi_host_read_program, g_scsi_host.pio_offset_read);
+        pio_remove_program(SCSI_PIO, &scsi_host_read_parity_program, g_scsi_host.pio_offset_read_parity);
+    }
+    else
+    {
+        // Mark state machines and channels as being in use
+        pio_sm_claim(SCSI_PIO, SCSI_SM);
+        pio_sm_claim(SCSI_PIO, SCSI_PARITY_SM);
+        dma_channel_claim(SCSI_DMA_CH_A);
+        dma_channel_claim(SCSI_DMA_CH_B);
+        dma_channel_claim(SCSI_DMA_CH_C);
+        g_host_channels_claimed = true;
+    }
+
     // Asynchronous / synchronous SCSI read
-    g_scsi_host.pio_offset_async_read = pio_add_program(SCSI_PIO, &scsi_host_async_read_program);
-    g_scsi_host.pio_cfg_async_read = scsi_host_async_read_program_get_default_config(g_scsi_host.pio_offset_async_read);
-    sm_config_set_in_pins(&g_scsi_host.pio_cfg_async_read, SCSI_IO_DB0);
-    sm_config_set_sideset_pins(&g_scsi_host.pio_cfg_async_read, SCSI_OUT_ACK);
-    sm_config_set_out_shift(&g_scsi_host.pio_cfg_async_read, true, false, 32);
-    sm_config_set_in_shift(&g_scsi_host.pio_cfg_async_read, true, true, 32);
+    g_scsi_host.pio_offset_read = pio_add_program(SCSI_PIO, &scsi_host_read_program);
+    g_scsi_host.pio_cfg_read = scsi_host_read_program_get_default_config(g_scsi_host.pio_offset_read);
+    sm_config_set_in_pins(&g_scsi_host.pio_cfg_read, SCSI_IO_DB0);
+    sm_config_set_sideset_pins(&g_scsi_host.pio_cfg_read, SCSI_OUT_ACK);
+    sm_config_set_out_shift(&g_scsi_host.pio_cfg_read, true, false, 32);
+    sm_config_set_in_shift(&g_scsi_host.pio_cfg_read, true, true, 32);
+
+    // Read parity check
+    g_scsi_host.pio_offset_read_parity = pio_add_program(SCSI_PIO, &scsi_host_read_parity_program);
+    g_scsi_host.pio_cfg_read_parity = scsi_host_read_parity_program_get_default_config(g_scsi_host.pio_offset_read_parity);
+    sm_config_set_out_shift(&g_scsi_host.pio_cfg_read_parity, true, true, 32);
+    sm_config_set_in_shift(&g_scsi_host.pio_cfg_read_parity, true, false, 32);
+
+    // The program is loaded with the asynchronous timing
+    g_scsi_host.syncOffset = 0;
+    g_scsi_host.syncPeriod = 0;
+
+    // Channel A: Bytes from scsi_host_read_parity PIO to destination memory buffer
+    // This takes the bottom 8 bits which is the data without parity bit.
+    // Triggered by scsi_host_read_parity RX FIFO.
+    dma_channel_config cfg = dma_channel_get_default_config(SCSI_DMA_CH_A);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_8);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, true);
+    channel_config_set_dreq(&cfg, pio_get_dreq(SCSI_PIO, SCSI_PARITY_SM, false));
+    g_scsi_host.dmacfg_read_chA = cfg;
+
+    // Channel B: Lookup from g_scsi_parity_check_lookup and copy to scsi_host_read_parity PIO
+    // Triggered by channel C writing to READ_ADDR_TRIG
+    // Re-enables channel C by chaining after done.
+    cfg = dma_channel_get_default_config(SCSI_DMA_CH_B);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, DREQ_FORCE);
+    channel_config_set_chain_to(&cfg, SCSI_DMA_CH_C);
+    cfg.ctrl |= DMA_CH0_CTRL_TRIG_HIGH_PRIORITY_BITS;
+    g_scsi_host.dmacfg_read_chB = cfg;
+
+    // Channel C: Addresses from scsi_host_read PIO to channel B READ_ADDR register
+    // A single transfer starts when PIO RX FIFO has data.
+    // The DMA channel is re-enabled by channel B chaining.
+    cfg = dma_channel_get_default_config(SCSI_DMA_CH_C);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, pio_get_dreq(SCSI_PIO, SCSI_SM, false));
+    g_scsi_host.dmacfg_read_chC = cfg;
 }
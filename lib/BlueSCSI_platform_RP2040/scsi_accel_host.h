@@ -6,6 +6,12 @@
 
 void scsi_accel_host_init();
 
+// Set SCSI access mode for following data phases.
+// Setting syncOffset = 0 enables asynchronous SCSI.
+// Setting syncOffset > 0 enables synchronous SCSI with the negotiated period.
+void scsi_accel_host_setSyncMode(int syncOffset, int syncPeriod);
+
 // Read data from SCSI bus.
-// Number of bytes to read must be divisible by two.
-uint32_t scsi_accel_host_read(uint8_t *buf, uint32_t count, int *parityError, uint32_t *parityResult, volatile int *resetFlag);
+// Returns the number of bytes received before target changed phase.
+// If parity error is detected in any byte, parityError is set to 1.
+uint32_t scsi_accel_host_read(uint8_t *buf, uint32_t count, int *parityError, volatile int *resetFlag);
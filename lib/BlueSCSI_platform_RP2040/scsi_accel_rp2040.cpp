@@ -10,6 +10,7 @@
 
 #include "BlueSCSI_platform.h"
 #include "BlueSCSI_log.h"
+#include "BlueSCSI_timeline.h"
 #include "scsi_accel_rp2040.h"
 #include "scsi_accel.pio.h"
 #include <hardware/pio.h>
@@ -183,9 +184,12 @@ static void start_dma_write()
     if (bytes_to_send == 0)
     {
         g_scsi_dma_state = SCSIDMA_WRITE_DONE;
+        timeline_record(TIMELINE_EVT_DMA_STOP, 0, 0);
         return;
     }
 
+    timeline_record(TIMELINE_EVT_DMA_START, 0, bytes_to_send);
+
     uint8_t *src_buf = &g_scsi_dma.app_buf[g_scsi_dma.dma_bytes];
     g_scsi_dma.dma_bytes += bytes_to_send;
     
@@ -518,9 +522,12 @@ static void start_dma_read()
     if (bytes_to_read == 0)
     {
         g_scsi_dma_state = SCSIDMA_READ_DONE;
+        timeline_record(TIMELINE_EVT_DMA_STOP, 1, 0);
         return;
     }
 
+    timeline_record(TIMELINE_EVT_DMA_START, 1, bytes_to_read);
+
     if (g_scsi_dma.syncOffset == 0)
     {
         // Start sending dummy words to scsi_accel_read state machine
@@ -8,6 +8,8 @@
 #ifdef SD_USE_SDIO
 
 #include "BlueSCSI_log.h"
+#include "BlueSCSI_timeline.h"
+#include "BlueSCSI_stats.h"
 #include "rp2040_sdio.h"
 #include <hardware/gpio.h>
 #include <SdFat.h>
@@ -368,6 +370,8 @@ bool SdioCard::writeSector(uint32_t sector, const uint8_t* src)
 
     // If possible, report transfer status to application through callback.
     sd_callback_t callback = get_stream_callback(src, 512, "writeSector", sector);
+    timeline_record(TIMELINE_EVT_SD_START, 1, sector);
+    uint32_t start_us = platform_time_us();
 
     // Cards up to 2GB use byte addressing, SDHC cards use sector addressing
     uint32_t address = (type() == SD_CARD_TYPE_SDHC) ? sector : (sector * 512);
@@ -389,6 +393,8 @@ bool SdioCard::writeSector(uint32_t sector, const uint8_t* src)
             callback(m_stream_count_start + bytes_done);
         }
     } while (g_sdio_error == SDIO_BUSY);
+    timeline_record(TIMELINE_EVT_SD_END, 1, 1);
+    scsiStatsSdTime(platform_time_us() - start_us);
 
     if (g_sdio_error != SDIO_OK)
     {
@@ -414,6 +420,8 @@ bool SdioCard::writeSectors(uint32_t sector, const uint8_t* src, size_t n)
     }
 
     sd_callback_t callback = get_stream_callback(src, n * 512, "writeSectors", sector);
+    timeline_record(TIMELINE_EVT_SD_START, 1, sector);
+    uint32_t start_us = platform_time_us();
 
     // Cards up to 2GB use byte addressing, SDHC cards use sector addressing
     uint32_t address = (type() == SD_CARD_TYPE_SDHC) ? sector : (sector * 512);
@@ -437,6 +445,8 @@ bool SdioCard::writeSectors(uint32_t sector, const uint8_t* src, size_t n)
             callback(m_stream_count_start + bytes_done);
         }
     } while (g_sdio_error == SDIO_BUSY);
+    timeline_record(TIMELINE_EVT_SD_END, 1, n);
+    scsiStatsSdTime(platform_time_us() - start_us);
 
     if (g_sdio_error != SDIO_OK)
     {
@@ -462,6 +472,8 @@ bool SdioCard::readSector(uint32_t sector, uint8_t* dst)
     }
 
     sd_callback_t callback = get_stream_callback(dst, 512, "readSector", sector);
+    timeline_record(TIMELINE_EVT_SD_START, 0, sector);
+    uint32_t start_us = platform_time_us();
 
     // Cards up to 2GB use byte addressing, SDHC cards use sector addressing
     uint32_t address = (type() == SD_CARD_TYPE_SDHC) ? sector : (sector * 512);
@@ -485,6 +497,8 @@ bool SdioCard::readSector(uint32_t sector, uint8_t* dst)
             callback(m_stream_count_start + bytes_done);
         }
     } while (g_sdio_error == SDIO_BUSY);
+    timeline_record(TIMELINE_EVT_SD_END, 0, 1);
+    scsiStatsSdTime(platform_time_us() - start_us);
 
     if (g_sdio_error != SDIO_OK)
     {
@@ -515,6 +529,8 @@ bool SdioCard::readSectors(uint32_t sector, uint8_t* dst, size_t n)
     }
 
     sd_callback_t callback = get_stream_callback(dst, n * 512, "readSectors", sector);
+    timeline_record(TIMELINE_EVT_SD_START, 0, sector);
+    uint32_t start_us = platform_time_us();
 
     // Cards up to 2GB use byte addressing, SDHC cards use sector addressing
     uint32_t address = (type() == SD_CARD_TYPE_SDHC) ? sector : (sector * 512);
@@ -538,6 +554,8 @@ bool SdioCard::readSectors(uint32_t sector, uint8_t* dst, size_t n)
             callback(m_stream_count_start + bytes_done);
         }
     } while (g_sdio_error == SDIO_BUSY);
+    timeline_record(TIMELINE_EVT_SD_END, 0, n);
+    scsiStatsSdTime(platform_time_us() - start_us);
 
     if (g_sdio_error != SDIO_OK)
     {
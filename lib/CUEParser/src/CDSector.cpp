@@ -0,0 +1,102 @@
+/*
+ * CD-ROM sector EDC and ECC generation.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CDSector.h"
+#include <string.h>
+
+static struct {
+    bool initialized;
+    uint8_t ecc_f[256]; // Multiply by alpha in GF(2^8)
+    uint8_t ecc_b[256]; // Divide by (1 + alpha)
+    uint32_t edc[256];
+} g_cd_tables;
+
+static void cd_init_tables()
+{
+    for (int i = 0; i < 256; i++)
+    {
+        // GF(2^8) with primitive polynomial x^8 + x^4 + x^3 + x^2 + 1
+        int j = (i << 1) ^ ((i & 0x80) ? 0x11D : 0);
+        g_cd_tables.ecc_f[i] = j;
+        g_cd_tables.ecc_b[i ^ j] = i;
+
+        // CRC polynomial (x^16 + x^15 + x^2 + 1)(x^16 + x^2 + x + 1), LSB first
+        uint32_t edc = i;
+        for (int k = 0; k < 8; k++)
+        {
+            edc = (edc >> 1) ^ ((edc & 1) ? 0xD8018001 : 0);
+        }
+        g_cd_tables.edc[i] = edc;
+    }
+
+    g_cd_tables.initialized = true;
+}
+
+uint32_t cd_edc_compute(uint32_t edc, const uint8_t *data, size_t len)
+{
+    if (!g_cd_tables.initialized) cd_init_tables();
+
+    const uint32_t *table = g_cd_tables.edc;
+    while (len--)
+    {
+        edc = (edc >> 8) ^ table[(edc ^ *data++) & 0xFF];
+    }
+    return edc;
+}
+
+// Compute one set of RS parity vectors over the 2340 bytes starting at header.
+// P parity uses 86 vectors of 24 bytes, Q parity 52 diagonal vectors of 43 bytes.
+static void cd_ecc_block(const uint8_t *src, int major_count, int minor_count,
+                         int major_mult, int minor_inc, uint8_t *dest)
+{
+    const uint8_t *ecc_f = g_cd_tables.ecc_f;
+    const uint8_t *ecc_b = g_cd_tables.ecc_b;
+    int size = major_count * minor_count;
+
+    for (int major = 0; major < major_count; major++)
+    {
+        int index = (major >> 1) * major_mult + (major & 1);
+        uint8_t ecc_a = 0;
+        uint8_t ecc_x = 0;
+        for (int minor = 0; minor < minor_count; minor++)
+        {
+            uint8_t temp = src[index];
+            index += minor_inc;
+            if (index >= size) index -= size;
+            ecc_a ^= temp;
+            ecc_x ^= temp;
+            ecc_a = ecc_f[ecc_a];
+        }
+        ecc_a = ecc_b[ecc_f[ecc_a] ^ ecc_x];
+        dest[major] = ecc_a;
+        dest[major + major_count] = ecc_a ^ ecc_x;
+    }
+}
+
+void cd_mode1_generate_ecc(uint8_t *sector)
+{
+    uint32_t edc = cd_edc_compute(0, sector, CD_MODE1_EDC_OFFSET);
+    sector[CD_MODE1_EDC_OFFSET + 0] = edc;
+    sector[CD_MODE1_EDC_OFFSET + 1] = edc >> 8;
+    sector[CD_MODE1_EDC_OFFSET + 2] = edc >> 16;
+    sector[CD_MODE1_EDC_OFFSET + 3] = edc >> 24;
+    memset(sector + CD_MODE1_EDC_OFFSET + 4, 0, 8);
+
+    // Q parity covers P parity, so P must be computed first
+    cd_ecc_block(sector + 12, 86, 24, 2, 86, sector + CD_MODE1_P_OFFSET);
+    cd_ecc_block(sector + 12, 52, 43, 86, 88, sector + CD_MODE1_Q_OFFSET);
+}
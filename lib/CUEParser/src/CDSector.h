@@ -0,0 +1,36 @@
+/*
+ * CD-ROM sector EDC and ECC generation.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Refer to ECMA-130 Annex A (CRC) and Annex B (Reed-Solomon product code).
+// Lookup tables are built in RAM on first use.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define CD_SECTOR_SIZE 2352
+#define CD_MODE1_EDC_OFFSET 0x810
+#define CD_MODE1_P_OFFSET 0x81C
+#define CD_MODE1_Q_OFFSET 0x8C8
+
+// Update EDC (CRC32 with CD polynomial) over data, start with edc = 0
+uint32_t cd_edc_compute(uint32_t edc, const uint8_t *data, size_t len);
+
+// Fill in EDC, zero field and P/Q parity of a Mode 1 sector.
+// Sync, header and 2048 bytes of user data must be already in place.
+void cd_mode1_generate_ecc(uint8_t *sector);
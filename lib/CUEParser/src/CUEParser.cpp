@@ -285,3 +285,31 @@ uint32_t CUEParser::get_sector_length(CUEFileMode filemode, CUETrackMode trackmo
         return 0;
     }
 }
+
+int cue_find_track(const CUETrackEntry *tracks, int count, uint32_t lba, int hint)
+{
+    // Consecutive accesses usually land in the same track
+    if (hint >= 0 && hint < count && tracks[hint].track_start <= lba &&
+        (hint + 1 == count || lba < tracks[hint + 1].track_start))
+    {
+        return hint;
+    }
+
+    // Binary search for the last track that starts at or before lba
+    int low = 0;
+    int high = count;
+    while (low < high)
+    {
+        int mid = (low + high) / 2;
+        if (tracks[mid].track_start <= lba)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return low - 1;
+}
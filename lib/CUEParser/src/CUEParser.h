@@ -75,6 +75,26 @@ struct CUETrackInfo
     uint32_t track_start;
 };
 
+// Compact form of CUETrackInfo without the file name,
+// for keeping a parsed track table in RAM.
+struct CUETrackEntry
+{
+    uint32_t file_offset; // CD image files are always below 4 GB
+    uint32_t track_start;
+    uint32_t data_start;
+    uint16_t sector_length;
+    uint8_t track_number;
+    uint8_t track_mode; // CUETrackMode
+    uint8_t file_mode; // CUEFileMode
+    uint8_t file_index; // Order of FILE in cue sheet, starting from 0
+};
+
+// Find the track containing the given LBA in a table sorted by track_start.
+// The track at index 'hint' is checked first, so passing the result of the
+// previous lookup makes consecutive reads within a track cheap.
+// Returns index of the track, or -1 if LBA is before the first track.
+int cue_find_track(const CUETrackEntry *tracks, int count, uint32_t lba, int hint);
+
 class CUEParser
 {
 public:
@@ -0,0 +1,166 @@
+#include "CDSector.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Unit test helpers */
+#define COMMENT(x) printf("\n----" x "----\n");
+#define TEST(x) \
+    if (!(x)) { \
+        fprintf(stderr, "\033[31;1mFAILED:\033[22;39m %s:%d %s\n", __FILE__, __LINE__, #x); \
+        status = false; \
+    } else { \
+        printf("\033[32;1mOK:\033[22;39m %s\n", #x); \
+    }
+
+/* Reference implementations written directly from ECMA-130 */
+static uint32_t edc_bitwise(const uint8_t *data, size_t len)
+{
+    uint32_t crc = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++)
+        {
+            crc = (crc >> 1) ^ ((crc & 1) ? 0xD8018001 : 0);
+        }
+    }
+    return crc;
+}
+
+static uint8_t gf_mul(uint8_t a, uint8_t b)
+{
+    uint8_t result = 0;
+    while (b)
+    {
+        if (b & 1) result ^= a;
+        a = (a << 1) ^ ((a & 0x80) ? 0x1D : 0);
+        b >>= 1;
+    }
+    return result;
+}
+
+// Check both syndromes of a RS codeword with parity check matrix
+// [1 1 ... 1; a^(n-1) ... a 1]
+static bool rs_syndromes_zero(const uint8_t *v, int n)
+{
+    uint8_t s0 = 0, s1 = 0;
+    for (int i = 0; i < n; i++)
+    {
+        s0 ^= v[i];
+        s1 = gf_mul(s1, 2) ^ v[i]; // Horner's rule
+    }
+    return s0 == 0 && s1 == 0;
+}
+
+static bool check_p_parity(const uint8_t *sector)
+{
+    const uint8_t *s = sector + 12;
+    for (int col = 0; col < 86; col++)
+    {
+        uint8_t v[26];
+        for (int i = 0; i < 26; i++) v[i] = s[col + 86 * i];
+        if (!rs_syndromes_zero(v, 26)) return false;
+    }
+    return true;
+}
+
+static bool check_q_parity(const uint8_t *sector)
+{
+    const uint8_t *s = sector + 12;
+    for (int diag = 0; diag < 52; diag++)
+    {
+        uint8_t v[45];
+        for (int i = 0; i < 43; i++)
+        {
+            v[i] = s[((diag >> 1) * 86 + (diag & 1) + 88 * i) % 2236];
+        }
+        v[43] = s[2236 + diag];
+        v[44] = s[2288 + diag];
+        if (!rs_syndromes_zero(v, 45)) return false;
+    }
+    return true;
+}
+
+static void make_sector(uint8_t *sector, uint32_t lba, unsigned seed)
+{
+    memset(sector, 0xEE, CD_SECTOR_SIZE);
+    sector[0] = 0;
+    memset(sector + 1, 0xFF, 10);
+    sector[11] = 0;
+
+    uint32_t msf = lba + 150;
+    uint8_t m = msf / (60 * 75), s = (msf / 75) % 60, f = msf % 75;
+    sector[12] = ((m / 10) << 4) | (m % 10);
+    sector[13] = ((s / 10) << 4) | (s % 10);
+    sector[14] = ((f / 10) << 4) | (f % 10);
+    sector[15] = 1;
+
+    srand(seed);
+    for (int i = 0; i < 2048; i++)
+    {
+        sector[16 + i] = (seed == 0) ? 0 : rand();
+    }
+}
+
+bool test_edc()
+{
+    bool status = true;
+    uint8_t data[1000];
+    for (int i = 0; i < 1000; i++) data[i] = i * 7 + 3;
+
+    COMMENT("test_edc()");
+    TEST(cd_edc_compute(0, data, 0) == 0);
+    TEST(cd_edc_compute(0, data, 1000) == edc_bitwise(data, 1000));
+    TEST(cd_edc_compute(cd_edc_compute(0, data, 123), data + 123, 877) == edc_bitwise(data, 1000));
+    return status;
+}
+
+bool test_mode1_ecc()
+{
+    bool status = true;
+    static uint8_t sector[CD_SECTOR_SIZE];
+
+    COMMENT("test_mode1_ecc()");
+    COMMENT("Zero user data at LBA 0");
+    make_sector(sector, 0, 0);
+    cd_mode1_generate_ecc(sector);
+    uint32_t edc = sector[0x810] | (sector[0x811] << 8) | (sector[0x812] << 16) | ((uint32_t)sector[0x813] << 24);
+    TEST(edc == edc_bitwise(sector, 0x810));
+    TEST(edc_bitwise(sector, 0x814) == 0);
+    TEST(sector[0x814] == 0 && memcmp(sector + 0x814, sector + 0x815, 7) == 0);
+    TEST(check_p_parity(sector));
+    TEST(check_q_parity(sector));
+
+    COMMENT("Random user data at various LBAs");
+    bool all_ok = true;
+    for (unsigned i = 1; i <= 50; i++)
+    {
+        make_sector(sector, i * 6007, i);
+        cd_mode1_generate_ecc(sector);
+        all_ok = all_ok && edc_bitwise(sector, 0x814) == 0;
+        all_ok = all_ok && check_p_parity(sector) && check_q_parity(sector);
+    }
+    TEST(all_ok);
+
+    COMMENT("Corrupted sector is detected");
+    sector[100] ^= 0x01;
+    TEST(edc_bitwise(sector, 0x814) != 0);
+    TEST(!check_p_parity(sector));
+    TEST(!check_q_parity(sector));
+
+    return status;
+}
+
+int main()
+{
+    if (test_edc() && test_mode1_ecc())
+    {
+        return 0;
+    }
+    else
+    {
+        printf("Some tests failed\n");
+        return 1;
+    }
+}
@@ -230,10 +230,105 @@ FILE "issue422.bin" BINARY
     return status;
 }
 
+bool test_findtrack()
+{
+    bool status = true;
+    const char *cue_sheet = R"(
+FILE "Image Name.bin" BINARY
+  TRACK 01 MODE1/2048
+    INDEX 01 00:00:00
+  TRACK 02 AUDIO
+    PREGAP 00:02:00
+    INDEX 01 02:47:20
+  TRACK 03 AUDIO
+    INDEX 00 07:55:58
+    INDEX 01 07:55:65
+  TRACK 04 AUDIO
+    INDEX 01 09:00:00
+    )";
+
+    CUEParser parser(cue_sheet);
+    CUETrackEntry tracks[4];
+    int count = 0;
+    const CUETrackInfo *track;
+    while ((track = parser.next_track()) != NULL && count < 4)
+    {
+        tracks[count].file_offset = track->file_offset;
+        tracks[count].track_start = track->track_start;
+        tracks[count].data_start = track->data_start;
+        tracks[count].sector_length = track->sector_length;
+        tracks[count].track_number = track->track_number;
+        tracks[count].track_mode = track->track_mode;
+        tracks[count].file_mode = track->file_mode;
+        count++;
+    }
+
+    uint32_t start2 = ((2 * 60) + 47) * 75 + 20;
+    uint32_t start3_i0 = ((7 * 60) + 55) * 75 + 58;
+    uint32_t start3_i1 = ((7 * 60) + 55) * 75 + 65;
+    uint32_t start4 = 9 * 60 * 75;
+
+    COMMENT("test_findtrack()");
+    TEST(count == 4);
+
+    COMMENT("Test track boundaries");
+    TEST(cue_find_track(tracks, count, 0, -1) == 0);
+    TEST(cue_find_track(tracks, count, start2 - 1, -1) == 0);
+    TEST(cue_find_track(tracks, count, start2, -1) == 1);
+    TEST(cue_find_track(tracks, count, start4 - 1, -1) == 2);
+    TEST(cue_find_track(tracks, count, start4, -1) == 3);
+    TEST(cue_find_track(tracks, count, 0xFFFFFFFF, -1) == 3);
+
+    COMMENT("Test unstored pregap belongs to the track");
+    TEST(cue_find_track(tracks, count, start2 + 2 * 75 - 1, -1) == 1);
+    TEST(cue_find_track(tracks, count, start2 + 2 * 75, -1) == 1);
+
+    COMMENT("Test INDEX 00 belongs to the track");
+    TEST(cue_find_track(tracks, count, start3_i0 - 1, -1) == 1);
+    TEST(cue_find_track(tracks, count, start3_i0, -1) == 2);
+    TEST(cue_find_track(tracks, count, start3_i1 - 1, -1) == 2);
+    TEST(cue_find_track(tracks, count, start3_i1, -1) == 2);
+
+    COMMENT("Test hint");
+    TEST(cue_find_track(tracks, count, start3_i0, 2) == 2);
+    TEST(cue_find_track(tracks, count, start3_i0 - 1, 2) == 1);
+    TEST(cue_find_track(tracks, count, start4, 2) == 3);
+    TEST(cue_find_track(tracks, count, 0, 3) == 0);
+    TEST(cue_find_track(tracks, count, start2, 99) == 1);
+
+    COMMENT("Test LBA before first track and empty table");
+    tracks[0].track_start = 150;
+    TEST(cue_find_track(tracks, count, 149, -1) == -1);
+    TEST(cue_find_track(tracks, count, 149, 0) == -1);
+    TEST(cue_find_track(tracks, count, 150, -1) == 0);
+    TEST(cue_find_track(tracks, 0, 0, 0) == -1);
+
+    COMMENT("Test every LBA against linear search");
+    tracks[0].track_start = 0;
+    bool all_ok = true;
+    int hint = 0;
+    for (uint32_t lba = 0; lba < start4 + 100; lba++)
+    {
+        int expected = -1;
+        for (int i = 0; i < count && tracks[i].track_start <= lba; i++)
+        {
+            expected = i;
+        }
+
+        hint = cue_find_track(tracks, count, lba, hint);
+        if (hint != expected || cue_find_track(tracks, count, lba, -1) != expected)
+        {
+            all_ok = false;
+        }
+    }
+    TEST(all_ok);
+
+    return status;
+}
 
 int main()
 {
-    if (test_basics() && test_datatracks() && test_datatrackpregap())
+    if (test_basics() && test_datatracks() && test_datatrackpregap() && test_findtrack())
     {
         return 0;
     }
@@ -0,0 +1,9 @@
+// Command statistics implemented in BlueSCSI_stats.cpp
+
+#ifndef S2S_BLUESCSI_STATS_H
+#define S2S_BLUESCSI_STATS_H
+
+// Handles LOG SENSE and LOG SELECT, returns 1 if command was handled
+int scsiStatsCommand(void);
+
+#endif
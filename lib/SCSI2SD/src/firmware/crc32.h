@@ -0,0 +1,34 @@
+// CRC-32 as used by Ethernet, zlib and PNG (reflected polynomial 0xEDB88320).
+//
+// The portable implementation processes 8 bytes per step with slicing-by-8
+// tables. Platforms that define PLATFORM_HAS_CRC32_COPY in BlueSCSI_platform.h
+// provide platform_crc32_copy(), which crc32_copy() uses to compute the
+// checksum in hardware while copying the data. Build with CRC32_NO_PLATFORM
+// to get the portable implementation only, e.g. for host side tests.
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Continue a checksum over more data, start with crc = 0
+uint32_t crc32_update(uint32_t crc, const void *buf, size_t len);
+
+static inline uint32_t crc32(const void *buf, size_t len)
+{
+	return crc32_update(0, buf, len);
+}
+
+// Copy len bytes from src to dst and return the checksum of the data
+uint32_t crc32_copy(void *dst, const void *src, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
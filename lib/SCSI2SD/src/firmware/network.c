@@ -21,86 +21,371 @@
 #include "scsiPhy.h"
 #include "config.h"
 #include "network.h"
+#include "network_queue.h"
+#include "crc32.h"
 
-static bool scsiNetworkEnabled = false;
+static volatile bool scsiNetworkEnabled = false;
 
-struct scsiNetworkPacketQueue {
-	uint8_t packets[NETWORK_PACKET_QUEUE_SIZE][NETWORK_PACKET_MAX_SIZE];
-	uint16_t sizes[NETWORK_PACKET_QUEUE_SIZE];
-	uint8_t writeIndex;
-	uint8_t readIndex;
+static uint8_t scsiNetworkInboundBuf[NETWORK_QUEUE_BYTES] __attribute__((aligned(4)));
+static uint8_t scsiNetworkOutboundBuf[NETWORK_QUEUE_BYTES] __attribute__((aligned(4)));
+
+static struct network_queue scsiNetworkInboundQueue = {
+	.buf = scsiNetworkInboundBuf,
+	.size = sizeof(scsiNetworkInboundBuf),
+};
+static struct network_queue scsiNetworkOutboundQueue = {
+	.buf = scsiNetworkOutboundBuf,
+	.size = sizeof(scsiNetworkOutboundBuf),
 };
 
-static struct scsiNetworkPacketQueue scsiNetworkInboundQueue, scsiNetworkOutboundQueue;
+// Outbound frames are sent from platform_network_poll(), a frame the radio
+// refuses stays at the head of the ring until NETWORK_TX_TIMEOUT_MS has passed
+static struct {
+	bool stalled;
+	uint32_t stallStart;
+} scsiNetworkTx;
+
+// Receive filter applied before inbound frames are checksummed and queued.
+// Multicast groups are kept as a 64 bit hash table like on Ethernet
+// controllers, indexed by the top 6 bits of the CRC-32 of the address.
+// Until the host adds its first group all multicast frames are accepted.
+static struct {
+	uint32_t multicastHash[2];
+	bool multicastSet;
+	uint32_t broadcastTokens;
+	uint32_t broadcastTime;
+} scsiNetworkFilter;
+
+// Indexed by enum scsi_network_stat, queue state is filled in when reported
+static uint32_t scsiNetworkStats[NETWORK_STAT_COUNT];
+static uint32_t scsiNetworkStatsLogTime;
 
 struct __attribute__((packed)) wifi_network_entry wifi_network_list[WIFI_NETWORK_LIST_ENTRY_COUNT] = { 0 };
 
-static const uint32_t crc32_tab[] = {
-	0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
-	0xe963a535, 0x9e6495a3,	0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
-	0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91, 0x1db71064, 0x6ab020f2,
-	0xf3b97148, 0x84be41de,	0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
-	0x136c9856, 0x646ba8c0, 0xfd62f97a, 0x8a65c9ec,	0x14015c4f, 0x63066cd9,
-	0xfa0f3d63, 0x8d080df5,	0x3b6e20c8, 0x4c69105e, 0xd56041e4, 0xa2677172,
-	0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b,	0x35b5a8fa, 0x42b2986c,
-	0xdbbbc9d6, 0xacbcf940,	0x32d86ce3, 0x45df5c75, 0xdcd60dcf, 0xabd13d59,
-	0x26d930ac, 0x51de003a, 0xc8d75180, 0xbfd06116, 0x21b4f4b5, 0x56b3c423,
-	0xcfba9599, 0xb8bda50f, 0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924,
-	0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d,	0x76dc4190, 0x01db7106,
-	0x98d220bc, 0xefd5102a, 0x71b18589, 0x06b6b51f, 0x9fbfe4a5, 0xe8b8d433,
-	0x7807c9a2, 0x0f00f934, 0x9609a88e, 0xe10e9818, 0x7f6a0dbb, 0x086d3d2d,
-	0x91646c97, 0xe6635c01, 0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e,
-	0x6c0695ed, 0x1b01a57b, 0x8208f4c1, 0xf50fc457, 0x65b0d9c6, 0x12b7e950,
-	0x8bbeb8ea, 0xfcb9887c, 0x62dd1ddf, 0x15da2d49, 0x8cd37cf3, 0xfbd44c65,
-	0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2, 0x4adfa541, 0x3dd895d7,
-	0xa4d1c46d, 0xd3d6f4fb, 0x4369e96a, 0x346ed9fc, 0xad678846, 0xda60b8d0,
-	0x44042d73, 0x33031de5, 0xaa0a4c5f, 0xdd0d7cc9, 0x5005713c, 0x270241aa,
-	0xbe0b1010, 0xc90c2086, 0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
-	0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4, 0x59b33d17, 0x2eb40d81,
-	0xb7bd5c3b, 0xc0ba6cad, 0xedb88320, 0x9abfb3b6, 0x03b6e20c, 0x74b1d29a,
-	0xead54739, 0x9dd277af, 0x04db2615, 0x73dc1683, 0xe3630b12, 0x94643b84,
-	0x0d6d6a3e, 0x7a6a5aa8, 0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1,
-	0xf00f9344, 0x8708a3d2, 0x1e01f268, 0x6906c2fe, 0xf762575d, 0x806567cb,
-	0x196c3671, 0x6e6b06e7, 0xfed41b76, 0x89d32be0, 0x10da7a5a, 0x67dd4acc,
-	0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5, 0xd6d6a3e8, 0xa1d1937e,
-	0x38d8c2c4, 0x4fdff252, 0xd1bb67f1, 0xa6bc5767, 0x3fb506dd, 0x48b2364b,
-	0xd80d2bda, 0xaf0a1b4c, 0x36034af6, 0x41047a60, 0xdf60efc3, 0xa867df55,
-	0x316e8eef, 0x4669be79, 0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236,
-	0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f, 0xc5ba3bbe, 0xb2bd0b28,
-	0x2bb45a92, 0x5cb36a04, 0xc2d7ffa7, 0xb5d0cf31, 0x2cd99e8b, 0x5bdeae1d,
-	0x9b64c2b0, 0xec63f226, 0x756aa39c, 0x026d930a, 0x9c0906a9, 0xeb0e363f,
-	0x72076785, 0x05005713, 0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38,
-	0x92d28e9b, 0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21, 0x86d3d2d4, 0xf1d4e242,
-	0x68ddb3f8, 0x1fda836e, 0x81be16cd, 0xf6b9265b, 0x6fb077e1, 0x18b74777,
-	0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c, 0x8f659eff, 0xf862ae69,
-	0x616bffd3, 0x166ccf45, 0xa00ae278, 0xd70dd2ee, 0x4e048354, 0x3903b3c2,
-	0xa7672661, 0xd06016f7, 0x4969474d, 0x3e6e77db, 0xaed16a4a, 0xd9d65adc,
-	0x40df0b66, 0x37d83bf0, 0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9,
-	0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605, 0xcdd70693,
-	0x54de5729, 0x23d967bf, 0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94,
-	0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
+static void scsiNetworkCountTime(enum scsi_network_stat total, enum scsi_network_stat max, uint32_t us)
+{
+	scsiNetworkStats[total] += us;
+	if (us > scsiNetworkStats[max])
+		scsiNetworkStats[max] = us;
+}
+
+// Frame read by the host, stamp is the time it was queued
+static void scsiNetworkCountDelivered(uint32_t stamp)
+{
+	scsiNetworkStats[NETWORK_STAT_RX_DELIVERED]++;
+	scsiNetworkCountTime(NETWORK_STAT_RX_WAIT_TOTAL, NETWORK_STAT_RX_WAIT_MAX, platform_time_us() - stamp);
+}
+
+static uint32_t scsiNetworkMulticastHash(const uint8_t *mac)
+{
+	return crc32(mac, 6) >> 26;
+}
+
+static void scsiNetworkAddMulticast(const uint8_t *mac)
+{
+	uint32_t hash = scsiNetworkMulticastHash(mac);
+	scsiNetworkFilter.multicastHash[hash >> 5] |= 1u << (hash & 31);
+	scsiNetworkFilter.multicastSet = true;
+}
+
+// Token bucket, one token per 1 / NETWORK_RX_BROADCAST_LIMIT seconds
+static bool scsiNetworkBroadcastAllowed(void)
+{
+#if NETWORK_RX_BROADCAST_LIMIT > 0
+	const uint32_t interval = 1000000 / NETWORK_RX_BROADCAST_LIMIT;
+	uint32_t now = platform_time_us();
+	uint32_t earned = (now - scsiNetworkFilter.broadcastTime) / interval;
+
+	if (scsiNetworkFilter.broadcastTokens + earned >= NETWORK_RX_BROADCAST_BURST)
+	{
+		scsiNetworkFilter.broadcastTokens = NETWORK_RX_BROADCAST_BURST;
+		scsiNetworkFilter.broadcastTime = now;
+	}
+	else
+	{
+		scsiNetworkFilter.broadcastTokens += earned;
+		scsiNetworkFilter.broadcastTime += earned * interval;
+	}
+
+	if (scsiNetworkFilter.broadcastTokens == 0)
+		return false;
+
+	scsiNetworkFilter.broadcastTokens--;
+#endif
+	return true;
+}
+
+// Returns false and counts the drop if the host does not want the frame
+static bool scsiNetworkFilterAccepts(const uint8_t *dst)
+{
+	static const uint8_t broadcast[6] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+
+	if (!(dst[0] & 0x01))
+	{
+		if (memcmp(dst, platform_network_mac(), 6) == 0)
+			return true;
+
+		scsiNetworkStats[NETWORK_STAT_RX_DROP_UNICAST]++;
+		return false;
+	}
+	else if (memcmp(dst, broadcast, 6) == 0)
+	{
+		if (scsiNetworkBroadcastAllowed())
+			return true;
+
+		scsiNetworkStats[NETWORK_STAT_RX_DROP_BROADCAST]++;
+		return false;
+	}
+	else
+	{
+		uint32_t hash = scsiNetworkMulticastHash(dst);
+		if (!scsiNetworkFilter.multicastSet || (scsiNetworkFilter.multicastHash[hash >> 5] & (1u << (hash & 31))))
+			return true;
+
+		scsiNetworkStats[NETWORK_STAT_RX_DROP_MULTICAST]++;
+		return false;
+	}
+}
+
+static void scsiNetworkUpdateStats(void)
+{
+	scsiNetworkStats[NETWORK_STAT_RX_DROP_SIZE] = scsiNetworkInboundQueue.dropped_size;
+	scsiNetworkStats[NETWORK_STAT_RX_DROP_FULL] = scsiNetworkInboundQueue.dropped_full;
+	scsiNetworkStats[NETWORK_STAT_RX_QUEUED] = network_queue_count(&scsiNetworkInboundQueue);
+	scsiNetworkStats[NETWORK_STAT_RX_HIGH_WATER] = scsiNetworkInboundQueue.high_water;
+	scsiNetworkStats[NETWORK_STAT_TX_DROP_SIZE] = scsiNetworkOutboundQueue.dropped_size;
+	scsiNetworkStats[NETWORK_STAT_TX_DROP_FULL] = scsiNetworkOutboundQueue.dropped_full;
+	scsiNetworkStats[NETWORK_STAT_TX_QUEUED] = network_queue_count(&scsiNetworkOutboundQueue);
+	scsiNetworkStats[NETWORK_STAT_TX_HIGH_WATER] = scsiNetworkOutboundQueue.high_water;
+	scsiNetworkStats[NETWORK_STAT_RADIO_RX] = g_platform_network_counters.rx_frames;
+	scsiNetworkStats[NETWORK_STAT_RADIO_TX_ERRORS] = g_platform_network_counters.tx_errors;
+}
+
+static void scsiNetworkResetStats(void)
+{
+	memset(scsiNetworkStats, 0, sizeof(scsiNetworkStats));
+	memset(&g_platform_network_counters, 0, sizeof(g_platform_network_counters));
+	scsiNetworkInboundQueue.dropped_size = 0;
+	scsiNetworkInboundQueue.dropped_full = 0;
+	scsiNetworkInboundQueue.high_water = network_queue_count(&scsiNetworkInboundQueue);
+	scsiNetworkOutboundQueue.dropped_size = 0;
+	scsiNetworkOutboundQueue.dropped_full = 0;
+	scsiNetworkOutboundQueue.high_water = network_queue_count(&scsiNetworkOutboundQueue);
+}
+
+static void scsiNetworkLogStats(void)
+{
+	uint32_t *st = scsiNetworkStats;
+
+	scsiNetworkUpdateStats();
+	log_f("Network rx: %u frames, %u read by host, dropped %u disabled / %u size / %u full, queue %u (max %u), wait %u us max, crc %u us max",
+		st[NETWORK_STAT_RX_FRAMES], st[NETWORK_STAT_RX_DELIVERED],
+		st[NETWORK_STAT_RX_DROP_DISABLED], st[NETWORK_STAT_RX_DROP_SIZE], st[NETWORK_STAT_RX_DROP_FULL],
+		st[NETWORK_STAT_RX_QUEUED], st[NETWORK_STAT_RX_HIGH_WATER],
+		st[NETWORK_STAT_RX_WAIT_MAX], st[NETWORK_STAT_CRC_TIME_MAX]);
+	log_f("Network rx filter: dropped %u unicast / %u multicast / %u broadcast",
+		st[NETWORK_STAT_RX_DROP_UNICAST], st[NETWORK_STAT_RX_DROP_MULTICAST], st[NETWORK_STAT_RX_DROP_BROADCAST]);
+	log_f("Network tx: %u frames, %u sent, %u busy, dropped %u timeout / %u size / %u full, queue %u (max %u), wait %u us max",
+		st[NETWORK_STAT_TX_FRAMES], st[NETWORK_STAT_TX_SENT], st[NETWORK_STAT_TX_BUSY],
+		st[NETWORK_STAT_TX_DROP_TIMEOUT], st[NETWORK_STAT_TX_DROP_SIZE], st[NETWORK_STAT_TX_DROP_FULL],
+		st[NETWORK_STAT_TX_QUEUED], st[NETWORK_STAT_TX_HIGH_WATER], st[NETWORK_STAT_TX_WAIT_MAX]);
+}
+
+// Fill scsiDev.data with the SCSI_NETWORK_WIFI_CMD_STATS response,
+// returns the number of bytes to send
+static uint32_t scsiNetworkReportStats(uint32_t size, bool reset)
+{
+	uint32_t len = 2 + NETWORK_STAT_COUNT * 4;
+
+	scsiNetworkUpdateStats();
+	scsiDev.data[0] = ((NETWORK_STAT_COUNT * 4) >> 8) & 0xff;
+	scsiDev.data[1] = (NETWORK_STAT_COUNT * 4) & 0xff;
+	for (int i = 0; i < NETWORK_STAT_COUNT; i++)
+	{
+		scsiDev.data[2 + i * 4] = (scsiNetworkStats[i] >> 24) & 0xff;
+		scsiDev.data[3 + i * 4] = (scsiNetworkStats[i] >> 16) & 0xff;
+		scsiDev.data[4 + i * 4] = (scsiNetworkStats[i] >> 8) & 0xff;
+		scsiDev.data[5 + i * 4] = scsiNetworkStats[i] & 0xff;
+	}
+
+	if (reset)
+		scsiNetworkResetStats();
+
+	return (len < size ? len : size);
+}
+
+// Copy as many queued packets as fit in size bytes of scsiDev.data,
+// returns the number of bytes used
+static uint32_t scsiNetworkBatchRead(uint32_t size)
+{
+	uint32_t len = 0;
+	const uint8_t *packet;
+	uint16_t plen;
+	uint32_t stamp;
+	long psize;
+
+	if (size > sizeof(scsiDev.data))
+		size = sizeof(scsiDev.data);
+
+	while ((packet = network_queue_peek(&scsiNetworkInboundQueue, &plen, &stamp)) != NULL)
+	{
+		psize = plen;
+
+		// pad smaller packets
+		if (psize < 64)
+			psize = 64;
+
+		if (len + 6 + psize > size)
+		{
+			if (len > 0 || size < 6)
+				break;
+
+			log_f("%s: packet size too big (%d)", __func__, psize);
+			psize = size - 6;
+		}
+
+		memcpy(scsiDev.data + len + 6, packet, psize);
+		scsiDev.data[len + 0] = (psize >> 8) & 0xff;
+		scsiDev.data[len + 1] = psize & 0xff;
+
+		network_queue_pop(&scsiNetworkInboundQueue);
+		scsiNetworkCountDelivered(stamp);
+
+		// flags, more data to read?
+		scsiDev.data[len + 2] = 0;
+		scsiDev.data[len + 3] = 0;
+		scsiDev.data[len + 4] = 0;
+		scsiDev.data[len + 5] = (network_queue_empty(&scsiNetworkInboundQueue) ? 0 : 0x10);
+
+		len += 6 + psize;
+	}
+
+	// terminating empty header
+	if (len + 6 <= size)
+	{
+		memset(scsiDev.data + len, 0, 6);
+		len += 6;
+	}
+
+	return len;
+}
+
+// Hold the host in write(6) while the radio drains the outbound ring,
+// returns false if there is still no room after NETWORK_TX_TIMEOUT_MS
+static bool scsiNetworkWaitForTxRoom(uint32_t size)
+{
+	uint32_t start = s2s_getTime_ms();
+
+	while (!network_queue_has_room(&scsiNetworkOutboundQueue, size))
+	{
+		if (s2s_elapsedTime_ms(start) > NETWORK_TX_TIMEOUT_MS)
+			return false;
+
+		platform_network_poll();
+	}
+
+	return true;
+}
+
+// Send the 6 byte read(6) header from scsiDev.data, up to body bytes of the
+// packet from its ring slot and zero padding up to total bytes, queued back
+// to back in a single DATA_IN transfer
+static void scsiNetworkSendPacket(const uint8_t *packet, uint32_t body, uint32_t total)
+{
+	uint8_t *padding = scsiDev.data + 6;
+
+	if (body > total - 6)
+		body = total - 6;
+	uint32_t pad = total - 6 - body;
+	memset(padding, 0, pad);
+
+	scsiStartWrite(scsiDev.data, 6);
+	if (body)
+		scsiStartWrite(packet, body);
+	if (pad)
+		scsiStartWrite(padding, pad);
+
+	while (!scsiIsWriteFinished(NULL))
+	{
+		platform_poll();
+	}
+	scsiFinishWrite();
+}
+
+enum scsi_network_slot_result {
+	NETWORK_SLOT_DONE,		// frame read and queued or dropped
+	NETWORK_SLOT_NO_ROOM,	// ring still full after NETWORK_TX_TIMEOUT_MS
+	NETWORK_SLOT_TOO_LARGE,	// frame does not fit in a slot
 };
 
-uint32_t crc32(const void *buf, size_t size)
+// Read a write(6) frame from the bus straight into an outbound ring slot.
+// The cont variant wraps the frame in a 4 byte header with its length and
+// 4 trailing bytes. The header is read to scsiDev.data and the rest to the
+// slot, so the frame still starts at the beginning of the slot.
+// Returns before the data phase is started if the frame was not read.
+static enum scsi_network_slot_result scsiNetworkReadToSlot(uint32_t size, bool cont)
 {
-	const uint8_t *p = buf;
-	uint32_t crc;
+	uint32_t len = cont ? size + 4 : size;
+	uint32_t payload = size;
+	int parityError = 0;
+
+	if (size > NETWORK_PACKET_MAX_SIZE)
+		return NETWORK_SLOT_TOO_LARGE;
 
-	crc = ~0U;
-	while (size--)
-		crc = crc32_tab[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
-	return crc ^ ~0U;
+	if (!scsiNetworkWaitForTxRoom(len))
+		return NETWORK_SLOT_NO_ROOM;
+
+	uint8_t *slot = network_queue_reserve(&scsiNetworkOutboundQueue, len);
+	if (slot == NULL)
+		return NETWORK_SLOT_NO_ROOM;
+
+	scsiEnterPhase(DATA_OUT);
+	if (cont)
+		scsiStartRead(scsiDev.data, 4, &parityError);
+	scsiStartRead(slot, len, &parityError);
+	scsiFinishRead(slot, len, &parityError);
+
+	if (cont)
+		size = (scsiDev.data[0] << 8) | scsiDev.data[1];
+
+	if (parityError)
+	{
+		DBGMSG_F("%s: read packet from host of size %zu (parity error %d)", __func__, size, parityError);
+		DBGMSG_BUF(slot, len);
+	}
+	else
+	{
+		DBGMSG_F("------ %s: read packet from host of size %zu", __func__, size);
+	}
+
+	// the slot is only published with a plausible length, otherwise
+	// it is reused by the next frame
+	if (size > payload)
+	{
+		scsiNetworkOutboundQueue.dropped_size++;
+		log_f("%s: dropping outgoing network packet, length %zu in header is larger than transfer", __func__, size);
+		return NETWORK_SLOT_DONE;
+	}
+
+	network_queue_commit(&scsiNetworkOutboundQueue, size, platform_time_us());
+	scsiNetworkStats[NETWORK_STAT_TX_FRAMES]++;
+	scsiNetworkStats[NETWORK_STAT_TX_BYTES] += size;
+	return NETWORK_SLOT_DONE;
 }
 
 int scsiNetworkCommand()
 {
 	int handled = 1;
-	int off = 0;
+	uint32_t off = 0;
 	int parityError = 0;
 	long psize;
+	const uint8_t *packet;
+	uint16_t plen;
+	uint32_t stamp;
 	uint32_t size = scsiDev.cdb[4] + (scsiDev.cdb[3] << 8);
 	uint8_t command = scsiDev.cdb[0];
 	uint8_t cont = (scsiDev.cdb[5] == 0x80);
+	enum scsi_network_slot_result slotResult;
 
 	DBGMSG_F("------ in scsiNetworkCommand with command 0x%02x (size %d)", command, size);
 
@@ -120,7 +405,10 @@ int scsiNetworkCommand()
 			break;
 		}
 
-		if (scsiNetworkInboundQueue.readIndex == scsiNetworkInboundQueue.writeIndex)
+		// The packet is sent straight from its ring slot, which stays
+		// reserved until the transfer is done.
+		packet = network_queue_peek(&scsiNetworkInboundQueue, &plen, &stamp);
+		if (packet == NULL)
 		{
 			// nothing available
 			memset(scsiDev.data, 0, 6);
@@ -128,7 +416,7 @@ int scsiNetworkCommand()
 		}
 		else
 		{
-			psize = scsiNetworkInboundQueue.sizes[scsiNetworkInboundQueue.readIndex];
+			psize = plen;
 
 			// pad smaller packets
 			if (psize < 64)
@@ -141,29 +429,25 @@ int scsiNetworkCommand()
 				psize = size - 6;
 			}
 
-			DBGMSG_F("%s: sending packet[%d] to host of size %zu + 6", __func__, scsiNetworkInboundQueue.readIndex, psize);
+			DBGMSG_F("%s: sending packet to host of size %zu + 6", __func__, psize);
 
 			scsiDev.dataLen = psize + 6; // 2-byte length + 4-byte flag + packet
-			memcpy(scsiDev.data + 6, scsiNetworkInboundQueue.packets[scsiNetworkInboundQueue.readIndex], psize);
 			scsiDev.data[0] = (psize >> 8) & 0xff;
 			scsiDev.data[1] = psize & 0xff;
 
-			if (scsiNetworkInboundQueue.readIndex == NETWORK_PACKET_QUEUE_SIZE - 1)
-				scsiNetworkInboundQueue.readIndex = 0;
-			else
-				scsiNetworkInboundQueue.readIndex++;
-
 			// flags
 			scsiDev.data[2] = 0;
 			scsiDev.data[3] = 0;
 			scsiDev.data[4] = 0;
 			// more data to read?
-			scsiDev.data[5] = (scsiNetworkInboundQueue.readIndex == scsiNetworkInboundQueue.writeIndex ? 0 : 0x10);
+			scsiDev.data[5] = (network_queue_count(&scsiNetworkInboundQueue) > 1 ? 0x10 : 0);
 
-			DBGMSG_BUF(scsiDev.data, scsiDev.dataLen);
+			DBGMSG_BUF(packet, psize);
 		}
 		// Patches around the weirdness on the Amiga SCSI devices
 		if ((scsiDev.cdb[0] == SCSI_NETWORK_WIFI_CMD) && (scsiDev.cdb[1] == SCSI_NETWORK_WIFI_CMD_ALTREAD)) {
+			// header, packet and padding are sent without copying the packet
+			uint32_t body = packet ? scsiDev.dataLen - 6 : 0;
 			scsiDev.data[2] = scsiDev.cdb[2];    // for me really
 			int extra = 0;
 			if (scsiDev.cdb[2] == AMIGASCSI_PATCH_24BYTE_BLOCKSIZE) {
@@ -176,20 +460,15 @@ int scsiNetworkCommand()
 						scsiDev.dataLen = NETWORK_PACKET_MAX_SIZE;
 					}
 				}
-				scsiEnterPhase(DATA_IN);
-				scsiWrite(scsiDev.data, scsiDev.dataLen);
-				while (!scsiIsWriteFinished(NULL))
-				{
-					platform_poll();
-				}
-				scsiFinishWrite();
-			} else {
-				extra = scsiDev.dataLen;     // F9 means send in ONE transaction
-				if (extra) scsiEnterPhase(DATA_IN);
 			}
+			// else F9 means send in ONE transaction
+
+			scsiEnterPhase(DATA_IN);
+			scsiNetworkSendPacket(packet, body, scsiDev.dataLen);
 
 			if (extra) {
 				// Just write the extra data to make the padding work for such a large packet
+				memset(scsiDev.data, 0, extra);
 				scsiWrite(scsiDev.data, extra);
 				while (!scsiIsWriteFinished(NULL))
 				{
@@ -211,7 +490,7 @@ int scsiNetworkCommand()
 			{
 				s2s_delay_us(80);
 
-				scsiWrite(scsiDev.data + 6, scsiDev.dataLen - 6);
+				scsiWrite(packet, scsiDev.dataLen - 6);
 				while (!scsiIsWriteFinished(NULL))
 				{
 					platform_poll();
@@ -220,6 +499,13 @@ int scsiNetworkCommand()
 			}
 		}
 
+		// release the ring slot
+		if (packet)
+		{
+			network_queue_pop(&scsiNetworkInboundQueue);
+			scsiNetworkCountDelivered(stamp);
+		}
+
 		scsiDev.status = GOOD;
 		scsiDev.phase = STATUS;
 		break;
@@ -236,6 +522,15 @@ int scsiNetworkCommand()
 
 	case 0x0a:
 		// write(6)
+		slotResult = scsiNetworkReadToSlot(size, cont);
+		if (slotResult == NETWORK_SLOT_DONE)
+		{
+			scsiDev.status = GOOD;
+			scsiDev.phase = STATUS;
+			break;
+		}
+
+		// no room or oversized frame, stage it in scsiDev.data
 		off = 0;
 		if (cont)
 		{
@@ -251,7 +546,7 @@ int scsiNetworkCommand()
 		if (parityError)
 		{
 			DBGMSG_F("%s: read packet from host of size %zu - %d (parity error %d)", __func__, size, (cont ? 4 : 0), parityError);
-			DBGMSG_F(scsiDev.data, size);
+			DBGMSG_BUF(scsiDev.data, size);
 		}
 		else
 		{
@@ -264,13 +559,33 @@ int scsiNetworkCommand()
 			off = 4;
 		}
 
-		memcpy(&scsiNetworkOutboundQueue.packets[scsiNetworkOutboundQueue.writeIndex], scsiDev.data + off, size);
-		scsiNetworkOutboundQueue.sizes[scsiNetworkOutboundQueue.writeIndex] = size;
-
-		if (scsiNetworkOutboundQueue.writeIndex == NETWORK_PACKET_QUEUE_SIZE - 1)
-			scsiNetworkOutboundQueue.writeIndex = 0;
+		if (size > NETWORK_PACKET_MAX_SIZE)
+		{
+			scsiNetworkOutboundQueue.dropped_size++;
+			log_f("%s: dropping outgoing network packet, too large (%zu)", __func__, size);
+		}
+		else if (slotResult == NETWORK_SLOT_NO_ROOM)
+		{
+			// already waited for room before the data phase
+			scsiNetworkOutboundQueue.dropped_full++;
+			DBGMSG_F("%s: dropping outgoing network packet, ring still full after %d ms", __func__, NETWORK_TX_TIMEOUT_MS);
+		}
 		else
-			scsiNetworkOutboundQueue.writeIndex++;
+		{
+			// back-pressure: status is delayed until the frame fits in the ring
+			if (!scsiNetworkWaitForTxRoom(size))
+				DBGMSG_F("%s: outbound ring still full after %d ms", __func__, NETWORK_TX_TIMEOUT_MS);
+
+			if (network_queue_push(&scsiNetworkOutboundQueue, scsiDev.data + off, size, platform_time_us()))
+			{
+				scsiNetworkStats[NETWORK_STAT_TX_FRAMES]++;
+				scsiNetworkStats[NETWORK_STAT_TX_BYTES] += size;
+			}
+			else
+			{
+				DBGMSG_F("%s: dropping outgoing network packet, ring is full", __func__);
+			}
+		}
 
 		scsiDev.status = GOOD;
 		scsiDev.phase = STATUS;
@@ -282,16 +597,34 @@ int scsiNetworkCommand()
 		break;
 
 	case 0x0d:
-		// add multicast addr to network filter
-		memset(scsiDev.data, 0, sizeof(scsiDev.data));
+		// add multicast addrs to network filter, 6 bytes each
+		if (unlikely(size < 6 || size % 6 != 0 || size > sizeof(scsiDev.data)))
+		{
+			scsiDev.target->sense.code = ILLEGAL_REQUEST;
+			scsiDev.target->sense.asc = INVALID_FIELD_IN_CDB;
+			scsiDev.status = CHECK_CONDITION;
+			scsiDev.phase = STATUS;
+			break;
+		}
+
 		scsiEnterPhase(DATA_OUT);
 		parityError = 0;
 		scsiRead(scsiDev.data, size, &parityError);
 
-		DBGMSG_F("%s: adding multicast address %02x:%02x:%02x:%02x:%02x:%02x", __func__,
-			  scsiDev.data[0], scsiDev.data[1], scsiDev.data[2], scsiDev.data[3], scsiDev.data[4], scsiDev.data[5]);
+		for (off = 0; off < size; off += 6)
+		{
+			uint8_t *mac = scsiDev.data + off;
+
+			// only group addresses belong in the multicast filter
+			if (!(mac[0] & 0x01))
+				continue;
+
+			DBGMSG_F("%s: adding multicast address %02x:%02x:%02x:%02x:%02x:%02x", __func__,
+				  mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
 
-		platform_network_add_multicast_address(scsiDev.data);
+			scsiNetworkAddMulticast(mac);
+			platform_network_add_multicast_address(mac);
+		}
 
 		scsiDev.status = GOOD;
 		scsiDev.phase = STATUS;
@@ -303,9 +636,16 @@ int scsiNetworkCommand()
 		{
 
 			DBGMSG_F("%s: enable interface", __func__);
+			if (!scsiNetworkEnabled)
+			{
+				// groups from an earlier session no longer apply
+				memset(&scsiNetworkFilter, 0, sizeof(scsiNetworkFilter));
+			}
 			scsiNetworkEnabled = true;
-			memset(&scsiNetworkInboundQueue, 0, sizeof(scsiNetworkInboundQueue));
-			memset(&scsiNetworkOutboundQueue, 0, sizeof(scsiNetworkOutboundQueue));
+			// only the consumer side may touch the inbound queue
+			network_queue_discard(&scsiNetworkInboundQueue);
+			network_queue_clear(&scsiNetworkOutboundQueue);
+			scsiNetworkTx.stalled = false;
 		}
 		else
 		{
@@ -456,6 +796,18 @@ int scsiNetworkCommand()
 			break;
 		}
 
+		case SCSI_NETWORK_WIFI_CMD_BATCHREAD:
+			// all queued packets in one data-in phase, for drivers that opt in
+			scsiDev.dataLen = scsiNetworkBatchRead(size);
+			DBGMSG_F("%s: sending %d bytes of batched packets to host", __func__, scsiDev.dataLen);
+			scsiDev.phase = DATA_IN;
+			break;
+
+		case SCSI_NETWORK_WIFI_CMD_STATS:
+			scsiDev.dataLen = scsiNetworkReportStats(size, scsiDev.cdb[2] & 0x01);
+			scsiDev.phase = DATA_IN;
+			break;
+
 		case SCSI_NETWORK_WIFI_CMD_GETMACADDRESS:
 			// Update for the gvpscsi.device on the Amiga as it doesn't like 0x09 command being called! - NOTE this only sends 6 bytes back
 			memcpy(scsiDev.data, scsiDev.boardCfg.wifiMACAddress, sizeof(scsiDev.boardCfg.wifiMACAddress));
@@ -474,35 +826,42 @@ int scsiNetworkCommand()
 	return handled;
 }
 
+// Called by the platform radio driver while it is being polled.
+// Must not log: drops are only counted and show up in the statistics.
 int scsiNetworkEnqueue(const uint8_t *buf, size_t len)
 {
 	if (!scsiNetworkEnabled)
+	{
+		scsiNetworkStats[NETWORK_STAT_RX_DROP_DISABLED]++;
 		return 0;
+	}
 
-	if (len + 4 > sizeof(scsiNetworkInboundQueue.packets[0]))
+	if (len < 6 || len + 4 > NETWORK_PACKET_MAX_SIZE)
 	{
-		DBGMSG_F("%s: dropping incoming network packet, too large (%zu > %zu)", __func__, len, sizeof(scsiNetworkInboundQueue.packets[0]));
+		scsiNetworkInboundQueue.dropped_size++;
 		return 0;
 	}
 
-	memcpy(scsiNetworkInboundQueue.packets[scsiNetworkInboundQueue.writeIndex], buf, len);
-	uint32_t crc = crc32(buf, len);
-	scsiNetworkInboundQueue.packets[scsiNetworkInboundQueue.writeIndex][len] = crc & 0xff;
-	scsiNetworkInboundQueue.packets[scsiNetworkInboundQueue.writeIndex][len + 1] = (crc >> 8) & 0xff;
-	scsiNetworkInboundQueue.packets[scsiNetworkInboundQueue.writeIndex][len + 2] = (crc >> 16) & 0xff;
-	scsiNetworkInboundQueue.packets[scsiNetworkInboundQueue.writeIndex][len + 3] = (crc >> 24) & 0xff;
+	if (!scsiNetworkFilterAccepts(buf))
+		return 0;
 
-	scsiNetworkInboundQueue.sizes[scsiNetworkInboundQueue.writeIndex] = len + 4;
+	// the slot being sent to the host is not released until the transfer is done
+	uint8_t *packet = network_queue_reserve(&scsiNetworkInboundQueue, len + 4);
+	if (packet == NULL)
+		return 0;
 
-	if (scsiNetworkInboundQueue.writeIndex == NETWORK_PACKET_QUEUE_SIZE - 1)
-		scsiNetworkInboundQueue.writeIndex = 0;
-	else
-		scsiNetworkInboundQueue.writeIndex++;
+	uint32_t start = platform_time_us();
+	uint32_t crc = crc32_copy(packet, buf, len);
+	scsiNetworkCountTime(NETWORK_STAT_CRC_TIME_TOTAL, NETWORK_STAT_CRC_TIME_MAX, platform_time_us() - start);
 
-	if (scsiNetworkInboundQueue.writeIndex == scsiNetworkInboundQueue.readIndex)
-	{
-		DBGMSG_F("%s: dropping packets in ring, write index caught up to read index", __func__);
-	}
+	packet[len] = crc & 0xff;
+	packet[len + 1] = (crc >> 8) & 0xff;
+	packet[len + 2] = (crc >> 16) & 0xff;
+	packet[len + 3] = (crc >> 24) & 0xff;
+
+	network_queue_commit(&scsiNetworkInboundQueue, len + 4, start);
+	scsiNetworkStats[NETWORK_STAT_RX_FRAMES]++;
+	scsiNetworkStats[NETWORK_STAT_RX_BYTES] += len;
 
 	return 1;
 }
@@ -510,20 +869,49 @@ int scsiNetworkEnqueue(const uint8_t *buf, size_t len)
 int scsiNetworkPurge(void)
 {
 	int sent = 0;
+	const uint8_t *packet;
+	uint16_t len;
+	uint32_t stamp;
 
 	if (!scsiNetworkEnabled)
 		return 0;
 
-	while (scsiNetworkOutboundQueue.readIndex != scsiNetworkOutboundQueue.writeIndex)
+	if (g_log_debug && s2s_elapsedTime_ms(scsiNetworkStatsLogTime) > NETWORK_STATS_LOG_INTERVAL_MS)
+	{
+		scsiNetworkStatsLogTime = s2s_getTime_ms();
+		scsiNetworkLogStats();
+	}
+
+	// send everything queued in one burst, stop when the radio is busy
+	while ((packet = network_queue_peek(&scsiNetworkOutboundQueue, &len, &stamp)) != NULL)
 	{
-		platform_network_send(scsiNetworkOutboundQueue.packets[scsiNetworkOutboundQueue.readIndex], scsiNetworkOutboundQueue.sizes[scsiNetworkOutboundQueue.readIndex]);
+		if (platform_network_send((uint8_t *)packet, len) != 0)
+		{
+			scsiNetworkStats[NETWORK_STAT_TX_BUSY]++;
+			if (!scsiNetworkTx.stalled)
+			{
+				scsiNetworkTx.stalled = true;
+				scsiNetworkTx.stallStart = s2s_getTime_ms();
+				break;
+			}
+			else if (s2s_elapsedTime_ms(scsiNetworkTx.stallStart) <= NETWORK_TX_TIMEOUT_MS)
+			{
+				break;
+			}
 
-		if (scsiNetworkOutboundQueue.readIndex == NETWORK_PACKET_QUEUE_SIZE - 1)
-			scsiNetworkOutboundQueue.readIndex = 0;
+			scsiNetworkStats[NETWORK_STAT_TX_DROP_TIMEOUT]++;
+			log_f("%s: dropping outgoing network packet after %d ms, %d still queued", __func__,
+				NETWORK_TX_TIMEOUT_MS, (int)network_queue_count(&scsiNetworkOutboundQueue) - 1);
+		}
 		else
-			scsiNetworkOutboundQueue.readIndex++;
+		{
+			scsiNetworkStats[NETWORK_STAT_TX_SENT]++;
+			scsiNetworkCountTime(NETWORK_STAT_TX_WAIT_TOTAL, NETWORK_STAT_TX_WAIT_MAX, platform_time_us() - stamp);
+			sent++;
+		}
 
-		sent++;
+		scsiNetworkTx.stalled = false;
+		network_queue_pop(&scsiNetworkOutboundQueue);
 	}
 
 	return sent;
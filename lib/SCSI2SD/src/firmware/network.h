@@ -34,12 +34,91 @@ extern "C" {
 #define SCSI_NETWORK_WIFI_CMD_ALTREAD       0x08   // gvpscsi.device on AMIGA doesnt like the standard version
 #define SCSI_NETWORK_WIFI_CMD_GETMACADDRESS 0x09   // gvpscsi.device on AMIGA doesnt like the standard version
 
+// Batch read, returns all queued packets that fit in the allocation length (cdb[3..4]).
+// Each packet has the same 6-byte header as read(6), the more-data flag tells if
+// packets remain queued after it. A header with zero length ends the batch if
+// there is room for it.
+#define SCSI_NETWORK_WIFI_CMD_BATCHREAD     0x0a
+
+// Network statistics, returns a 2-byte length followed by the counters of
+// enum scsi_network_stat as big-endian 32-bit values. Set bit 0 of cdb[2]
+// to reset the counters after they have been read.
+#define SCSI_NETWORK_WIFI_CMD_STATS         0x0b
+
 #define AMIGASCSI_PATCH_24BYTE_BLOCKSIZE 	0xA8   // In this mode, data written is rounded up to the nearest 24-byte boundary
 #define AMIGASCSI_PATCH_SINGLEWRITE_ONLY 	0xA9   // In this mode, data written is always ONLY as one single write command
 
-#define NETWORK_PACKET_QUEUE_SIZE   20		// must be <= 255
 #define NETWORK_PACKET_MAX_SIZE     1520
 
+// Bytes of packet ring per direction, see network_queue.h.
+// Holds 19 full size frames like the old 20 slot queue, or several times
+// as many small ones.
+#ifndef NETWORK_QUEUE_BYTES
+#define NETWORK_QUEUE_BYTES         (20 * (NETWORK_PACKET_MAX_SIZE + 4))
+#endif
+
+// How long an outbound frame is retried while the radio is busy, and
+// how long write(6) waits for room in the outbound ring
+#ifndef NETWORK_TX_TIMEOUT_MS
+#define NETWORK_TX_TIMEOUT_MS       250
+#endif
+
+// Inbound broadcast frames allowed per second on average, 0 for no limit,
+// and how many may arrive back to back before the limit applies
+#ifndef NETWORK_RX_BROADCAST_LIMIT
+#define NETWORK_RX_BROADCAST_LIMIT  0
+#endif
+#ifndef NETWORK_RX_BROADCAST_BURST
+#define NETWORK_RX_BROADCAST_BURST  32
+#endif
+
+// How often the statistics are written to the log when debug logging is on
+#ifndef NETWORK_STATS_LOG_INTERVAL_MS
+#define NETWORK_STATS_LOG_INTERVAL_MS 60000
+#endif
+
+// Counters reported by SCSI_NETWORK_WIFI_CMD_STATS, in report order.
+// Wait times are from queueing a frame until it is read by the host (rx)
+// or accepted by the radio (tx), all times are in microseconds.
+enum scsi_network_stat {
+	NETWORK_STAT_RX_FRAMES,			// frames queued for the host
+	NETWORK_STAT_RX_BYTES,
+	NETWORK_STAT_RX_DELIVERED,		// frames read by the host
+	NETWORK_STAT_RX_DROP_DISABLED,	// received while interface is disabled
+	NETWORK_STAT_RX_DROP_SIZE,
+	NETWORK_STAT_RX_DROP_FULL,
+	NETWORK_STAT_RX_QUEUED,
+	NETWORK_STAT_RX_HIGH_WATER,
+	NETWORK_STAT_RX_WAIT_TOTAL,
+	NETWORK_STAT_RX_WAIT_MAX,
+	NETWORK_STAT_CRC_TIME_TOTAL,
+	NETWORK_STAT_CRC_TIME_MAX,
+	NETWORK_STAT_TX_FRAMES,			// frames written by the host
+	NETWORK_STAT_TX_BYTES,
+	NETWORK_STAT_TX_SENT,			// frames accepted by the radio
+	NETWORK_STAT_TX_BUSY,			// send attempts refused by the radio
+	NETWORK_STAT_TX_DROP_TIMEOUT,
+	NETWORK_STAT_TX_DROP_SIZE,
+	NETWORK_STAT_TX_DROP_FULL,
+	NETWORK_STAT_TX_QUEUED,
+	NETWORK_STAT_TX_HIGH_WATER,
+	NETWORK_STAT_TX_WAIT_TOTAL,
+	NETWORK_STAT_TX_WAIT_MAX,
+	NETWORK_STAT_RADIO_RX,			// frames delivered by the radio driver
+	NETWORK_STAT_RADIO_TX_ERRORS,	// failed sends reported by the radio driver
+	NETWORK_STAT_RX_DROP_UNICAST,	// receive filter: not our MAC address
+	NETWORK_STAT_RX_DROP_MULTICAST,	// receive filter: group not subscribed by the host
+	NETWORK_STAT_RX_DROP_BROADCAST,	// receive filter: over NETWORK_RX_BROADCAST_LIMIT
+	NETWORK_STAT_COUNT
+};
+
+// Counters kept by the platform network driver
+struct platform_network_counters {
+	uint32_t rx_frames;
+	uint32_t tx_errors;
+};
+extern struct platform_network_counters g_platform_network_counters;
+
 struct __attribute__((packed)) wifi_network_entry {
 	char ssid[64];
 	char bssid[6];
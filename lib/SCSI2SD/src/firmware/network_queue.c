@@ -0,0 +1,174 @@
+// Packet queue backed by a contiguous byte ring, see network_queue.h
+
+#include <string.h>
+
+#include "network_queue.h"
+
+#define NETWORK_QUEUE_WRAP	0xFFFF	// header length of a wrap marker
+
+struct network_queue_hdr {
+	uint16_t len;
+	uint16_t reserved;
+	uint32_t stamp;
+};
+
+// Ring bytes used by a packet with len bytes of data
+static inline uint32_t recordSize(uint32_t len)
+{
+	if (len < NETWORK_QUEUE_MIN_PACKET)
+		len = NETWORK_QUEUE_MIN_PACKET;
+	return (sizeof(struct network_queue_hdr) + len + 3) & ~3;
+}
+
+void network_queue_init(struct network_queue *q, uint8_t *buf, uint32_t size)
+{
+	memset(q, 0, sizeof(*q));
+	q->buf = buf;
+	q->size = size & ~3;
+}
+
+void network_queue_clear(struct network_queue *q)
+{
+	q->head = 0;
+	q->tail = 0;
+	q->popped = q->pushed;
+}
+
+void network_queue_discard(struct network_queue *q)
+{
+	uint16_t len;
+	while (network_queue_peek(q, &len, NULL) != NULL)
+		network_queue_pop(q);
+}
+
+// Find offset for a record of need bytes, returns false if the ring is full.
+// head must never catch up with tail, that would look like an empty ring.
+static bool findRoom(const struct network_queue *q, uint32_t need, uint32_t *at)
+{
+	uint32_t head = q->head;
+	uint32_t tail = q->tail;
+
+	if (head >= tail)
+	{
+		if (head + need < q->size || (head + need == q->size && tail != 0))
+			*at = head;
+		else if (need < tail)
+			*at = 0;
+		else
+			return false;
+	}
+	else if (head + need < tail)
+	{
+		*at = head;
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+bool network_queue_has_room(const struct network_queue *q, uint16_t len)
+{
+	uint32_t at;
+	return len != NETWORK_QUEUE_WRAP && recordSize(len) <= q->size && findRoom(q, recordSize(len), &at);
+}
+
+uint8_t *network_queue_reserve(struct network_queue *q, uint16_t len)
+{
+	uint32_t need = recordSize(len);
+	uint32_t at;
+
+	if (len == NETWORK_QUEUE_WRAP || need > q->size)
+	{
+		q->dropped_size++;
+		return NULL;
+	}
+	else if (!findRoom(q, need, &at))
+	{
+		q->dropped_full++;
+		return NULL;
+	}
+
+	q->reserved_at = at;
+	q->reserved_len = len;
+	return q->buf + at + sizeof(struct network_queue_hdr);
+}
+
+void network_queue_commit(struct network_queue *q, uint16_t len, uint32_t stamp)
+{
+	uint32_t at = q->reserved_at;
+	uint32_t head = q->head;
+	struct network_queue_hdr *hdr = (struct network_queue_hdr *)(q->buf + at);
+
+	if (len > q->reserved_len)
+		len = q->reserved_len;
+
+	hdr->len = len;
+	hdr->stamp = stamp;
+	if (at != head)
+	{
+		// packet starts over at offset 0, tell the consumer to skip the end
+		((struct network_queue_hdr *)(q->buf + head))->len = NETWORK_QUEUE_WRAP;
+	}
+
+	head = at + recordSize(len);
+	if (head == q->size)
+		head = 0;
+
+	// data and headers must be visible before the consumer sees the new head
+	__sync_synchronize();
+	q->head = head;
+	q->pushed++;
+
+	if (q->pushed - q->popped > q->high_water)
+		q->high_water = q->pushed - q->popped;
+}
+
+bool network_queue_push(struct network_queue *q, const uint8_t *data, uint16_t len, uint32_t stamp)
+{
+	uint8_t *dst = network_queue_reserve(q, len);
+	if (dst == NULL)
+		return false;
+
+	memcpy(dst, data, len);
+	network_queue_commit(q, len, stamp);
+	return true;
+}
+
+const uint8_t *network_queue_peek(struct network_queue *q, uint16_t *len, uint32_t *stamp)
+{
+	uint32_t tail = q->tail;
+	if (tail == q->head)
+		return NULL;
+
+	__sync_synchronize();
+	const struct network_queue_hdr *hdr = (const struct network_queue_hdr *)(q->buf + tail);
+	if (hdr->len == NETWORK_QUEUE_WRAP)
+	{
+		tail = 0;
+		q->tail = 0;
+		hdr = (const struct network_queue_hdr *)q->buf;
+	}
+
+	*len = hdr->len;
+	if (stamp)
+		*stamp = hdr->stamp;
+	return q->buf + tail + sizeof(struct network_queue_hdr);
+}
+
+void network_queue_pop(struct network_queue *q)
+{
+	uint16_t len;
+	if (network_queue_peek(q, &len, NULL) == NULL)
+		return;
+
+	uint32_t tail = q->tail + recordSize(len);
+	if (tail == q->size)
+		tail = 0;
+
+	__sync_synchronize();
+	q->tail = tail;
+	q->popped++;
+}
@@ -0,0 +1,95 @@
+// Packet queue backed by a contiguous byte ring.
+//
+// Each packet is stored as a small header followed by its data, so short
+// frames only use as much of the ring as they need. The header also keeps
+// a caller supplied time stamp, used to measure how long packets wait.
+// A packet is never split at the end of the ring: when it does not fit,
+// a wrap marker is left behind and the packet starts again from offset 0.
+// Data returned by network_queue_peek() and network_queue_reserve() can
+// therefore be handed directly to DMA.
+//
+// The queue is safe for one producer and one consumer running in different
+// contexts: head and pushed are only written by the producer, tail and
+// popped only by the consumer.
+
+#ifndef NETWORK_QUEUE_H
+#define NETWORK_QUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Space reserved for data of every packet, so that readers padding short
+// frames to the Ethernet minimum never run past the end of the ring
+#define NETWORK_QUEUE_MIN_PACKET	64
+
+struct network_queue {
+	uint8_t *buf;
+	uint32_t size;				// multiple of 4
+
+	volatile uint32_t head;		// producer: offset of next packet
+	volatile uint32_t tail;		// consumer: offset of oldest packet
+	volatile uint32_t pushed;	// producer: packets committed
+	volatile uint32_t popped;	// consumer: packets released
+
+	uint32_t dropped_full;		// producer: no room in the ring
+	uint32_t dropped_size;		// producer: larger than allowed
+	uint32_t high_water;		// producer: most packets queued at once
+
+	// set by network_queue_reserve() for the following commit
+	uint32_t reserved_at;
+	uint32_t reserved_len;
+};
+
+// buf must be 4-byte aligned and size a multiple of 4
+void network_queue_init(struct network_queue *q, uint8_t *buf, uint32_t size);
+
+// Drop all queued packets. Producer and consumer must both be idle.
+void network_queue_clear(struct network_queue *q);
+
+// Consumer: drop all queued packets while the producer may still be running
+void network_queue_discard(struct network_queue *q);
+
+// Producer: reserve contiguous room for a packet of up to len bytes.
+// Returns NULL and counts a drop if the ring is full.
+uint8_t *network_queue_reserve(struct network_queue *q, uint16_t len);
+
+// Producer: check if a packet of len bytes would fit, without reserving it
+bool network_queue_has_room(const struct network_queue *q, uint16_t len);
+
+// Producer: publish the reserved packet with its final length
+// (<= reserved)
+void network_queue_commit(struct network_queue *q, uint16_t len,
+	uint32_t stamp);
+
+// Producer: copy a packet into the ring, returns false if it was dropped
+bool network_queue_push(struct network_queue *q, const uint8_t *data,
+	uint16_t len, uint32_t stamp);
+
+// Consumer: oldest packet with its length and time stamp (stamp may be
+// NULL), or NULL if the queue is empty. The data stays valid until
+// network_queue_pop().
+const uint8_t *network_queue_peek(struct network_queue *q, uint16_t *len,
+	uint32_t *stamp);
+
+// Consumer: release the packet returned by network_queue_peek()
+void network_queue_pop(struct network_queue *q);
+
+static inline uint32_t network_queue_count(const struct network_queue *q)
+{
+	return q->pushed - q->popped;
+}
+
+static inline bool network_queue_empty(const struct network_queue *q)
+{
+	return q->head == q->tail;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -29,6 +29,7 @@
 // #include "debug.h"
 // #include "log.h"
 #include "bluescsi_toolbox.h"
+#include "bluescsi_stats.h"
 #include "mo.h"
 #include "network.h"
 #include "tape.h"
@@ -636,6 +637,10 @@ static void process_Command()
 	{
 		// handled
 	}
+	else if (scsiStatsCommand())
+	{
+		// LOG SENSE / LOG SELECT
+	}
 	else if (scsiDiskCommand())
 	{
 		// Already handled.
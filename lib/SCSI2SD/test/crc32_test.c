@@ -0,0 +1,115 @@
+#include "crc32.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Unit test helpers */
+#define COMMENT(x) printf("\n----" x "----\n");
+#define TEST(x) \
+    if (!(x)) { \
+        fprintf(stderr, "\033[31;1mFAILED:\033[22;39m %s:%d %s\n", __FILE__, __LINE__, #x); \
+        status = false; \
+    } else { \
+        printf("\033[32;1mOK:\033[22;39m %s\n", #x); \
+    }
+
+/* Reference implementation, one bit at a time */
+static uint32_t crc32_bitwise(const uint8_t *data, size_t len)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++)
+        {
+            crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320 : 0);
+        }
+    }
+    return ~crc;
+}
+
+static uint32_t bitrev32(uint32_t v)
+{
+    uint32_t r = 0;
+    for (int i = 0; i < 32; i++)
+    {
+        r = (r << 1) | ((v >> i) & 1);
+    }
+    return r;
+}
+
+/* Model of RP2040 DMA sniffer as configured in rp2040_crc32.cpp:
+ * CRC32R mode shifts each byte in LSB first into a non-reflected CRC-32,
+ * OUT_REV and OUT_INV are applied when the result is read. */
+static uint32_t crc32_sniffer_model(const uint8_t *data, size_t len)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < len; i++)
+    {
+        for (int k = 0; k < 8; k++)
+        {
+            uint32_t bit = ((data[i] >> k) & 1) ^ (crc >> 31);
+            crc = (crc << 1) ^ (bit ? 0x04C11DB7 : 0);
+        }
+    }
+    return ~bitrev32(crc);
+}
+
+bool test_crc32()
+{
+    bool status = true;
+    static uint8_t buf[2048 + 8];
+
+    COMMENT("Known check values");
+    TEST(crc32("123456789", 9) == 0xCBF43926);
+    TEST(crc32("", 0) == 0);
+    TEST(crc32("The quick brown fox jumps over the lazy dog", 43) == 0x414FA339);
+
+    COMMENT("All lengths and alignments match bitwise reference");
+    srand(1);
+    for (size_t i = 0; i < sizeof(buf); i++) buf[i] = rand();
+    bool all_ok = true;
+    for (size_t offset = 0; offset < 8; offset++)
+    {
+        for (size_t len = 0; len <= 2048; len++)
+        {
+            all_ok = all_ok && crc32(buf + offset, len) == crc32_bitwise(buf + offset, len);
+        }
+    }
+    TEST(all_ok);
+
+    COMMENT("DMA sniffer configuration gives the same result");
+    all_ok = true;
+    for (size_t len = 0; len <= 1520; len += 7)
+    {
+        all_ok = all_ok && crc32_sniffer_model(buf, len) == crc32(buf, len);
+    }
+    TEST(all_ok);
+
+    COMMENT("Checksum can be continued over pieces");
+    uint32_t crc = crc32_update(0, buf, 5);
+    crc = crc32_update(crc, buf + 5, 1000);
+    crc = crc32_update(crc, buf + 1005, 514);
+    TEST(crc == crc32_bitwise(buf, 1519));
+
+    COMMENT("Copy returns checksum of copied data");
+    static uint8_t dst[1520];
+    TEST(crc32_copy(dst, buf + 3, 1514) == crc32_bitwise(buf + 3, 1514));
+    TEST(memcmp(dst, buf + 3, 1514) == 0);
+
+    return status;
+}
+
+int main()
+{
+    if (test_crc32())
+    {
+        return 0;
+    }
+    else
+    {
+        printf("Some tests failed\n");
+        return 1;
+    }
+}
@@ -0,0 +1,41 @@
+// Platform interface for host builds of the firmware network code,
+// implemented in network_host.c
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PLATFORM_NAME "BlueSCSI host"
+
+uint32_t platform_time_us(void);
+uint32_t platform_millis(void);
+void platform_delay_us(uint32_t us);
+void platform_poll(void);
+
+// Network functions
+bool platform_network_supported();
+void platform_network_poll();
+int platform_network_init(char *mac);
+const uint8_t *platform_network_mac();
+void platform_network_add_multicast_address(uint8_t *mac);
+bool platform_network_wifi_join(char *ssid, char *password);
+int platform_network_wifi_start_scan();
+int platform_network_wifi_scan_finished();
+void platform_network_wifi_dump_scan_list();
+int platform_network_wifi_rssi();
+char * platform_network_wifi_ssid();
+char * platform_network_wifi_bssid();
+int platform_network_wifi_channel();
+
+// Missing from glibc before 2.38
+size_t strlcpy(char *dst, const char *src, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
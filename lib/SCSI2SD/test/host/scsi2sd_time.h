@@ -0,0 +1,12 @@
+// Timing functions for host builds of the firmware code
+
+#pragma once
+
+#include <stdint.h>
+#include "BlueSCSI_platform.h"
+
+#define s2s_getTime_ms() platform_millis()
+#define s2s_elapsedTime_ms(since) ((uint32_t)(platform_millis() - (since)))
+#define s2s_delay_ms(x) platform_delay_us((x) * 1000)
+#define s2s_delay_us(x) platform_delay_us(x)
+#define s2s_delay_ns(x) platform_delay_us(((x) + 999) / 1000)
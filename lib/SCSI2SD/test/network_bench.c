@@ -0,0 +1,320 @@
+// Scripted DaynaPORT initiator for load testing network.c on a Linux host.
+//
+// Usage: network_bench [options] script
+//   -b BACKEND  frame source and sink: none, tap:IFNAME or pcap:FILE (default none)
+//   -o FILE     write frames sent to the network to a pcap file
+//   -r N        frames received per poll (default 8)
+//   -p          replay pcap frames at their captured rate
+//   -B PCT      make PCT percent of sends report a busy radio
+//   -v          enable debug log output from network.c
+//
+// Script commands, one per line, '#' starts a comment:
+//   enable | disable       toggle the interface (0x0e)
+//   read N                 N x read(6) of a single packet
+//   batchread ALLOC N      N x batch read with ALLOC byte allocation length
+//   drain                  read(6) until no packets are left
+//   write SIZE N           N x write(6) of a SIZE byte frame
+//   multicast MAC          add a multicast address to the receive filter (0x0d)
+//   poll N                 N x main loop network poll without SCSI commands
+//   sleep MS               wait with the network idle
+//   stats [reset]          print the counters of SCSI_NETWORK_WIFI_CMD_STATS
+//
+// Every command prints the number of SCSI commands, frames moved, frames per
+// second and the min / average / max time spent in scsiNetworkCommand().
+
+#include "network_host.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "BlueSCSI_platform.h"
+#include "scsi.h"
+#include "network.h"
+
+#define READ_ALLOC (NETWORK_PACKET_MAX_SIZE + 6)
+
+static const char *g_stat_names[NETWORK_STAT_COUNT] = {
+    [NETWORK_STAT_RX_FRAMES] = "rx_frames",
+    [NETWORK_STAT_RX_BYTES] = "rx_bytes",
+    [NETWORK_STAT_RX_DELIVERED] = "rx_delivered",
+    [NETWORK_STAT_RX_DROP_DISABLED] = "rx_drop_disabled",
+    [NETWORK_STAT_RX_DROP_SIZE] = "rx_drop_size",
+    [NETWORK_STAT_RX_DROP_FULL] = "rx_drop_full",
+    [NETWORK_STAT_RX_QUEUED] = "rx_queued",
+    [NETWORK_STAT_RX_HIGH_WATER] = "rx_high_water",
+    [NETWORK_STAT_RX_WAIT_TOTAL] = "rx_wait_total_us",
+    [NETWORK_STAT_RX_WAIT_MAX] = "rx_wait_max_us",
+    [NETWORK_STAT_CRC_TIME_TOTAL] = "crc_time_total_us",
+    [NETWORK_STAT_CRC_TIME_MAX] = "crc_time_max_us",
+    [NETWORK_STAT_TX_FRAMES] = "tx_frames",
+    [NETWORK_STAT_TX_BYTES] = "tx_bytes",
+    [NETWORK_STAT_TX_SENT] = "tx_sent",
+    [NETWORK_STAT_TX_BUSY] = "tx_busy",
+    [NETWORK_STAT_TX_DROP_TIMEOUT] = "tx_drop_timeout",
+    [NETWORK_STAT_TX_DROP_SIZE] = "tx_drop_size",
+    [NETWORK_STAT_TX_DROP_FULL] = "tx_drop_full",
+    [NETWORK_STAT_TX_QUEUED] = "tx_queued",
+    [NETWORK_STAT_TX_HIGH_WATER] = "tx_high_water",
+    [NETWORK_STAT_TX_WAIT_TOTAL] = "tx_wait_total_us",
+    [NETWORK_STAT_TX_WAIT_MAX] = "tx_wait_max_us",
+    [NETWORK_STAT_RADIO_RX] = "radio_rx",
+    [NETWORK_STAT_RADIO_TX_ERRORS] = "radio_tx_errors",
+    [NETWORK_STAT_RX_DROP_UNICAST] = "rx_drop_unicast",
+    [NETWORK_STAT_RX_DROP_MULTICAST] = "rx_drop_multicast",
+    [NETWORK_STAT_RX_DROP_BROADCAST] = "rx_drop_broadcast",
+};
+
+static uint8_t g_in[65536];
+static uint8_t g_out[NETWORK_PACKET_MAX_SIZE + 8];
+
+struct measurement {
+    uint32_t commands;
+    uint32_t frames;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t start_us;
+};
+
+static void measure_start(struct measurement *m)
+{
+    memset(m, 0, sizeof(*m));
+    m->min_us = UINT32_MAX;
+    m->start_us = platform_time_us();
+}
+
+// Run command like the firmware main loop would: command, then network poll
+static int run(struct measurement *m, const uint8_t *cdb, const uint8_t *out, uint32_t outLen, uint32_t *inLen)
+{
+    uint32_t start = platform_time_us();
+    int status = network_host_command(cdb, out, outLen, g_in, sizeof(g_in), inLen);
+    uint32_t us = platform_time_us() - start;
+
+    m->commands++;
+    m->total_us += us;
+    if (us < m->min_us) m->min_us = us;
+    if (us > m->max_us) m->max_us = us;
+
+    platform_network_poll();
+    return status;
+}
+
+static void measure_report(const char *name, const struct measurement *m)
+{
+    uint32_t elapsed = platform_time_us() - m->start_us;
+    printf("%-10s %7u cmds %7u frames %9.0f frames/s  cmd us min %u avg %.1f max %u\n",
+        name, m->commands, m->frames,
+        elapsed ? m->frames * 1e6 / elapsed : 0.0,
+        m->commands ? m->min_us : 0,
+        m->commands ? (double)m->total_us / m->commands : 0.0,
+        m->max_us);
+}
+
+// Returns number of packets in a read(6) or batch read response
+static uint32_t count_packets(uint32_t len)
+{
+    uint32_t count = 0;
+    uint32_t pos = 0;
+    while (pos + 6 <= len)
+    {
+        uint32_t psize = (g_in[pos] << 8) | g_in[pos + 1];
+        if (psize == 0) break;
+        count++;
+        pos += 6 + psize;
+    }
+    return count;
+}
+
+static void cmd_toggle(bool enable)
+{
+    uint8_t cdb[6] = { 0x0e, 0, 0, 0, 0, enable ? 0x80 : 0 };
+    struct measurement m;
+    uint32_t len;
+
+    measure_start(&m);
+    run(&m, cdb, NULL, 0, &len);
+    measure_report(enable ? "enable" : "disable", &m);
+}
+
+static void cmd_read(long count, bool drain)
+{
+    uint8_t cdb[6] = { 0x08, 0, 0, READ_ALLOC >> 8, READ_ALLOC & 0xff, 0xc0 };
+    struct measurement m;
+    uint32_t len;
+
+    measure_start(&m);
+    for (long i = 0; drain || i < count; i++)
+    {
+        run(&m, cdb, NULL, 0, &len);
+        uint32_t frames = count_packets(len);
+        m.frames += frames;
+        if (drain && frames == 0) break;
+    }
+    measure_report(drain ? "drain" : "read", &m);
+}
+
+static void cmd_batchread(long alloc, long count)
+{
+    uint8_t cdb[6] = { SCSI_NETWORK_WIFI_CMD, SCSI_NETWORK_WIFI_CMD_BATCHREAD, 0, alloc >> 8, alloc & 0xff, 0 };
+    struct measurement m;
+    uint32_t len;
+
+    measure_start(&m);
+    for (long i = 0; i < count; i++)
+    {
+        run(&m, cdb, NULL, 0, &len);
+        m.frames += count_packets(len);
+    }
+    measure_report("batchread", &m);
+}
+
+static void cmd_write(long size, long count)
+{
+    uint8_t cdb[6] = { 0x0a, 0, 0, size >> 8, size & 0xff, 0 };
+    struct measurement m;
+    uint32_t len;
+
+    // Broadcast frame with a sequence number in the payload
+    memset(g_out, 0xff, 6);
+    memcpy(g_out + 6, "\x00\x80\x19\x00\x00\x01\x88\xb5", 8);
+
+    measure_start(&m);
+    for (long i = 0; i < count; i++)
+    {
+        if (size >= 18) memcpy(g_out + 14, &i, 4);
+        if (run(&m, cdb, g_out, size, &len) == GOOD) m.frames++;
+    }
+    measure_report("write", &m);
+}
+
+static void cmd_poll(long count)
+{
+    struct measurement m;
+    uint32_t rx = g_network_host_counters.rx_frames;
+
+    measure_start(&m);
+    for (long i = 0; i < count; i++) platform_network_poll();
+    m.frames = g_network_host_counters.rx_frames - rx;
+    measure_report("poll", &m);
+}
+
+static bool cmd_multicast(const char *line)
+{
+    uint8_t cdb[6] = { 0x0d, 0, 0, 0, 6, 0 };
+    unsigned int mac[6];
+    uint32_t len;
+
+    if (sscanf(line, "%*s %x:%x:%x:%x:%x:%x", &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5]) != 6)
+        return false;
+
+    for (int i = 0; i < 6; i++) g_out[i] = mac[i];
+    network_host_command(cdb, g_out, 6, g_in, sizeof(g_in), &len);
+    return true;
+}
+
+static void cmd_stats(bool reset)
+{
+    uint8_t cdb[6] = { SCSI_NETWORK_WIFI_CMD, SCSI_NETWORK_WIFI_CMD_STATS, reset ? 1 : 0, 0xff, 0xff, 0 };
+    uint32_t len;
+
+    network_host_command(cdb, NULL, 0, g_in, sizeof(g_in), &len);
+    uint32_t count = ((g_in[0] << 8) | g_in[1]) / 4;
+    for (uint32_t i = 0; i < count && i < NETWORK_STAT_COUNT && 2 + i * 4 + 4 <= len; i++)
+    {
+        const uint8_t *p = g_in + 2 + i * 4;
+        printf("  %-20s %u\n", g_stat_names[i], (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]);
+    }
+    printf("  %-20s %u delivered, %u not yet replayed, %u sent, %u busy\n", "host backend",
+        g_network_host_counters.rx_frames, g_network_host_counters.rx_remaining,
+        g_network_host_counters.tx_frames, g_network_host_counters.tx_busy);
+}
+
+static bool run_script(FILE *f)
+{
+    char line[256];
+    int lineno = 0;
+
+    while (fgets(line, sizeof(line), f))
+    {
+        char cmd[32] = "", arg[32] = "";
+        long a = 1, b = 1;
+
+        lineno++;
+        char *comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+
+        int n = sscanf(line, "%31s %ld %ld", cmd, &a, &b);
+        if (n <= 0) continue;
+
+        bool valid = true;
+        if (strcmp(cmd, "enable") == 0) cmd_toggle(true);
+        else if (strcmp(cmd, "disable") == 0) cmd_toggle(false);
+        else if (strcmp(cmd, "read") == 0) cmd_read(a, false);
+        else if (strcmp(cmd, "drain") == 0) cmd_read(0, true);
+        else if (strcmp(cmd, "batchread") == 0 && n == 3) cmd_batchread(a, b);
+        else if (strcmp(cmd, "write") == 0 && n == 3) cmd_write(a, b);
+        else if (strcmp(cmd, "poll") == 0) cmd_poll(a);
+        else if (strcmp(cmd, "sleep") == 0) usleep(a * 1000);
+        else if (strcmp(cmd, "multicast") == 0) valid = cmd_multicast(line);
+        else if (strcmp(cmd, "stats") == 0)
+        {
+            sscanf(line, "%31s %31s", cmd, arg);
+            cmd_stats(strcmp(arg, "reset") == 0);
+        }
+        else valid = false;
+
+        if (!valid)
+        {
+            fprintf(stderr, "line %d: invalid command: %s", lineno, line);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *backend = "none";
+    const char *output = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:o:r:pB:v")) != -1)
+    {
+        switch (opt)
+        {
+            case 'b': backend = optarg; break;
+            case 'o': output = optarg; break;
+            case 'r': g_network_host_options.rx_burst = atoi(optarg); break;
+            case 'p': g_network_host_options.rx_paced = true; break;
+            case 'B': g_network_host_options.tx_busy_pct = atoi(optarg); break;
+            case 'v': g_log_debug = true; break;
+            default:
+                fprintf(stderr, "Usage: %s [-b none|tap:IFNAME|pcap:FILE] [-o out.pcap] [-r burst] [-p] [-B busy%%] [-v] script\n", argv[0]);
+                return 2;
+        }
+    }
+
+    if (optind >= argc)
+    {
+        fprintf(stderr, "No script given\n");
+        return 2;
+    }
+
+    FILE *script = strcmp(argv[optind], "-") == 0 ? stdin : fopen(argv[optind], "r");
+    if (!script)
+    {
+        perror(argv[optind]);
+        return 2;
+    }
+
+    if (!network_host_open(backend) || (output && !network_host_open_output(output)))
+    {
+        return 1;
+    }
+
+    bool ok = run_script(script);
+    network_host_close();
+    return ok ? 0 : 1;
+}
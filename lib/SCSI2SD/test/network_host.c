@@ -0,0 +1,510 @@
+// Host backend for network.c, see network_host.h
+
+#define _GNU_SOURCE
+#include "network_host.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <net/if.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/if_tun.h>
+
+#include "scsi.h"
+#include "scsiPhy.h"
+#include "network.h"
+
+struct network_host_options g_network_host_options = { 8, false, 0 };
+struct network_host_counters g_network_host_counters;
+struct platform_network_counters g_platform_network_counters;
+
+ScsiDevice scsiDev;
+bool g_log_debug;
+
+/*************************/
+/* Time and logging      */
+/*************************/
+
+static uint64_t time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+uint32_t platform_time_us(void)
+{
+    return (uint32_t)(time_ns() / 1000);
+}
+
+uint32_t platform_millis(void)
+{
+    return (uint32_t)(time_ns() / 1000000);
+}
+
+void platform_delay_us(uint32_t us)
+{
+    // Busy wait like the firmware, sleeping would add scheduler latency
+    uint64_t end = time_ns() + (uint64_t)us * 1000;
+    while (time_ns() < end);
+}
+
+void platform_poll(void)
+{
+}
+
+static void vlog(const char *format, va_list ap)
+{
+    fprintf(stderr, "[%10u] ", platform_time_us());
+    vfprintf(stderr, format, ap);
+    fputc('\n', stderr);
+}
+
+void log_f(const char *format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+    vlog(format, ap);
+    va_end(ap);
+}
+
+void dbgmsg_f(const char *format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+    vlog(format, ap);
+    va_end(ap);
+}
+
+void log_buf(const unsigned char *buf, unsigned long size)
+{
+    for (unsigned long i = 0; i < size; i++)
+    {
+        fprintf(stderr, "%02x%c", buf[i], (i % 16 == 15 || i + 1 == size) ? '\n' : ' ');
+    }
+}
+
+void dbgmsg_buf(const unsigned char *buf, unsigned long size)
+{
+    log_buf(buf, size);
+}
+
+#if !defined(__GLIBC__) || __GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38)
+size_t strlcpy(char *dst, const char *src, size_t size)
+{
+    size_t len = strlen(src);
+    if (size > 0)
+    {
+        size_t n = (len < size - 1) ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
+
+/*************************/
+/* Emulated SCSI PHY     */
+/*************************/
+
+static struct {
+    const uint8_t *out;
+    uint32_t outLen;
+    uint32_t outPos;
+    uint8_t *in;
+    uint32_t inMax;
+    uint32_t inLen;
+} g_phy;
+
+void scsiEnterPhase(int phase)
+{
+    scsiDev.phase = phase;
+}
+
+void scsiWrite(const uint8_t *data, uint32_t count)
+{
+    uint32_t n = count;
+    if (g_phy.inLen + n > g_phy.inMax) n = g_phy.inMax - g_phy.inLen;
+    memcpy(g_phy.in + g_phy.inLen, data, n);
+    g_phy.inLen += n;
+}
+
+void scsiStartWrite(const uint8_t *data, uint32_t count)
+{
+    scsiWrite(data, count);
+}
+
+void scsiFinishWrite(void)
+{
+}
+
+bool scsiIsWriteFinished(const uint8_t *data)
+{
+    (void)data;
+    return true;
+}
+
+void scsiRead(uint8_t *data, uint32_t count, int *parityError)
+{
+    // Initiator sends zeros if the target asks for more than was scripted
+    uint32_t n = g_phy.outLen - g_phy.outPos;
+    if (n > count) n = count;
+    memcpy(data, g_phy.out + g_phy.outPos, n);
+    memset(data + n, 0, count - n);
+    g_phy.outPos += n;
+    *parityError = 0;
+}
+
+void scsiStartRead(uint8_t *data, uint32_t count, int *parityError)
+{
+    scsiRead(data, count, parityError);
+}
+
+void scsiFinishRead(uint8_t *data, uint32_t count, int *parityError)
+{
+    (void)data;
+    (void)count;
+    (void)parityError;
+}
+
+bool scsiIsReadFinished(const uint8_t *data)
+{
+    (void)data;
+    return true;
+}
+
+int network_host_command(const uint8_t *cdb,
+    const uint8_t *out, uint32_t outLen,
+    uint8_t *in, uint32_t inMax, uint32_t *inLen)
+{
+    g_phy.out = out;
+    g_phy.outLen = outLen;
+    g_phy.outPos = 0;
+    g_phy.in = in;
+    g_phy.inMax = inMax;
+    g_phy.inLen = 0;
+
+    scsiDev.target = &scsiDev.targets[0];
+    memcpy(scsiDev.cdb, cdb, 6);
+    scsiDev.cdbLen = 6;
+    scsiDev.phase = COMMAND;
+    scsiDev.status = GOOD;
+    scsiDev.dataLen = 0;
+
+    if (!scsiNetworkCommand())
+    {
+        scsiDev.status = CHECK_CONDITION;
+    }
+    else if (scsiDev.phase == DATA_IN)
+    {
+        // Buffered response, sent by the main SCSI loop in the firmware
+        scsiWrite(scsiDev.data, scsiDev.dataLen);
+    }
+    else if (scsiDev.phase == DATA_OUT)
+    {
+        int parityError;
+        scsiRead(scsiDev.data, scsiDev.dataLen, &parityError);
+    }
+
+    *inLen = g_phy.inLen;
+    return scsiDev.status;
+}
+
+/*************************/
+/* Frame source and sink */
+/*************************/
+
+#define PCAP_MAGIC_US 0xa1b2c3d4
+#define PCAP_MAGIC_NS 0xa1b23c4d
+#define PCAP_LINKTYPE_ETHERNET 1
+
+struct pcap_frame {
+    uint64_t time_us;
+    uint16_t len;
+    uint8_t *data;
+};
+
+static struct {
+    int tap_fd;
+    struct pcap_frame *frames;
+    uint32_t frame_count;
+    uint32_t next_frame;
+    uint64_t replay_start_us;
+    FILE *output;
+} g_host = { .tap_fd = -1 };
+
+static uint32_t swap32(uint32_t v)
+{
+    return (v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000) | (v << 24);
+}
+
+static bool open_tap(const char *name)
+{
+    struct ifreq ifr;
+
+    g_host.tap_fd = open("/dev/net/tun", O_RDWR | O_NONBLOCK);
+    if (g_host.tap_fd < 0)
+    {
+        fprintf(stderr, "Failed to open /dev/net/tun: %s\n", strerror(errno));
+        return false;
+    }
+
+    memset(&ifr, 0, sizeof(ifr));
+    ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+    strncpy(ifr.ifr_name, name, IFNAMSIZ - 1);
+    if (ioctl(g_host.tap_fd, TUNSETIFF, &ifr) < 0)
+    {
+        fprintf(stderr, "Failed to attach TAP interface %s: %s\n", name, strerror(errno));
+        close(g_host.tap_fd);
+        g_host.tap_fd = -1;
+        return false;
+    }
+
+    return true;
+}
+
+static bool open_pcap(const char *path)
+{
+    uint32_t hdr[6];
+    uint32_t rec[4];
+
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        fprintf(stderr, "Failed to open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    if (fread(hdr, 4, 6, f) != 6)
+    {
+        fprintf(stderr, "%s: file is too short\n", path);
+        fclose(f);
+        return false;
+    }
+
+    bool swapped = (hdr[0] == swap32(PCAP_MAGIC_US) || hdr[0] == swap32(PCAP_MAGIC_NS));
+    uint32_t magic = swapped ? swap32(hdr[0]) : hdr[0];
+    uint32_t linktype = swapped ? swap32(hdr[5]) : hdr[5];
+    if ((magic != PCAP_MAGIC_US && magic != PCAP_MAGIC_NS) || linktype != PCAP_LINKTYPE_ETHERNET)
+    {
+        fprintf(stderr, "%s: not an Ethernet pcap file\n", path);
+        fclose(f);
+        return false;
+    }
+
+    uint32_t capacity = 0;
+    while (fread(rec, 4, 4, f) == 4)
+    {
+        for (int i = 0; i < 4 && swapped; i++) rec[i] = swap32(rec[i]);
+
+        if (g_host.frame_count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 1024;
+            g_host.frames = realloc(g_host.frames, capacity * sizeof(struct pcap_frame));
+        }
+
+        struct pcap_frame *frame = &g_host.frames[g_host.frame_count];
+        frame->time_us = (uint64_t)rec[0] * 1000000 + (magic == PCAP_MAGIC_NS ? rec[1] / 1000 : rec[1]);
+        frame->len = rec[2] > 0xFFFF ? 0xFFFF : rec[2];
+        frame->data = malloc(rec[2]);
+        if (fread(frame->data, 1, rec[2], f) != rec[2])
+        {
+            free(frame->data);
+            break;
+        }
+        g_host.frame_count++;
+    }
+
+    fclose(f);
+    g_network_host_counters.rx_remaining = g_host.frame_count;
+    return true;
+}
+
+// Default DaynaPORT MAC of the firmware, used by the receive filter
+static const uint8_t defaultMAC[] = { 0x00, 0x80, 0x19, 0xc0, 0xff, 0xee };
+
+bool network_host_open(const char *spec)
+{
+    memcpy(scsiDev.boardCfg.wifiMACAddress, defaultMAC, sizeof(defaultMAC));
+
+    if (strcmp(spec, "none") == 0)
+        return true;
+    else if (strncmp(spec, "tap:", 4) == 0)
+        return open_tap(spec + 4);
+    else if (strncmp(spec, "pcap:", 5) == 0)
+        return open_pcap(spec + 5);
+
+    fprintf(stderr, "Unknown network backend \"%s\"\n", spec);
+    return false;
+}
+
+bool network_host_open_output(const char *path)
+{
+    static const uint32_t hdr[6] = { PCAP_MAGIC_US, 0x00040002, 0, 0, 65535, PCAP_LINKTYPE_ETHERNET };
+
+    g_host.output = fopen(path, "wb");
+    if (!g_host.output)
+    {
+        fprintf(stderr, "Failed to create %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    fwrite(hdr, 4, 6, g_host.output);
+    return true;
+}
+
+void network_host_close(void)
+{
+    if (g_host.tap_fd >= 0) close(g_host.tap_fd);
+    if (g_host.output) fclose(g_host.output);
+    for (uint32_t i = 0; i < g_host.frame_count; i++) free(g_host.frames[i].data);
+    free(g_host.frames);
+    memset(&g_host, 0, sizeof(g_host));
+    g_host.tap_fd = -1;
+}
+
+static void deliver(const uint8_t *buf, size_t len)
+{
+    // Same as cyw43_cb_process_ethernet() on the Pico W
+    g_platform_network_counters.rx_frames++;
+    g_network_host_counters.rx_frames++;
+    scsiNetworkEnqueue(buf, len);
+}
+
+static void receive_frames(void)
+{
+    uint8_t buf[2048];
+
+    for (int i = 0; i < g_network_host_options.rx_burst; i++)
+    {
+        if (g_host.tap_fd >= 0)
+        {
+            ssize_t len = read(g_host.tap_fd, buf, sizeof(buf));
+            if (len <= 0) break;
+            deliver(buf, len);
+        }
+        else if (g_host.next_frame < g_host.frame_count)
+        {
+            struct pcap_frame *frame = &g_host.frames[g_host.next_frame];
+            if (g_network_host_options.rx_paced)
+            {
+                uint64_t now = time_ns() / 1000;
+                if (g_host.next_frame == 0) g_host.replay_start_us = now;
+                if (now - g_host.replay_start_us < frame->time_us - g_host.frames[0].time_us) break;
+            }
+
+            deliver(frame->data, frame->len);
+            g_host.next_frame++;
+            g_network_host_counters.rx_remaining--;
+        }
+        else
+        {
+            break;
+        }
+    }
+}
+
+/*************************/
+/* Platform network API  */
+/*************************/
+
+bool platform_network_supported()
+{
+    return true;
+}
+
+int platform_network_init(char *mac)
+{
+    (void)mac;
+    return 0;
+}
+
+void platform_network_poll()
+{
+    scsiNetworkPurge();
+    receive_frames();
+}
+
+int platform_network_send(uint8_t *buf, size_t len)
+{
+    if (g_network_host_options.tx_busy_pct > 0 && rand() % 100 < g_network_host_options.tx_busy_pct)
+    {
+        g_platform_network_counters.tx_errors++;
+        g_network_host_counters.tx_busy++;
+        return -1;
+    }
+
+    if (g_host.tap_fd >= 0 && write(g_host.tap_fd, buf, len) < 0)
+    {
+        g_platform_network_counters.tx_errors++;
+        return -1;
+    }
+
+    if (g_host.output)
+    {
+        uint64_t now = time_ns() / 1000;
+        uint32_t rec[4] = { (uint32_t)(now / 1000000), (uint32_t)(now % 1000000), (uint32_t)len, (uint32_t)len };
+        fwrite(rec, 4, 4, g_host.output);
+        fwrite(buf, 1, len, g_host.output);
+    }
+
+    g_network_host_counters.tx_frames++;
+    return 0;
+}
+
+const uint8_t *platform_network_mac()
+{
+    return defaultMAC;
+}
+
+void platform_network_add_multicast_address(uint8_t *mac)
+{
+    (void)mac;
+}
+
+bool platform_network_wifi_join(char *ssid, char *password)
+{
+    (void)ssid;
+    (void)password;
+    return true;
+}
+
+int platform_network_wifi_start_scan()
+{
+    return 0;
+}
+
+int platform_network_wifi_scan_finished()
+{
+    return 1;
+}
+
+void platform_network_wifi_dump_scan_list()
+{
+}
+
+int platform_network_wifi_rssi()
+{
+    return -40;
+}
+
+char * platform_network_wifi_ssid()
+{
+    static char ssid[] = "host";
+    return ssid;
+}
+
+char * platform_network_wifi_bssid()
+{
+    static char bssid[6];
+    return bssid;
+}
+
+int platform_network_wifi_channel()
+{
+    return 1;
+}
@@ -0,0 +1,46 @@
+// Host backend for the DaynaPORT network emulation in network.c.
+//
+// Replaces the SCSI PHY and the Pico W radio with plain Linux facilities:
+// frames sent by network.c go to a TAP device or an output pcap file, and
+// received frames come from the TAP device or are replayed from a pcap file.
+// SCSI commands are run directly through scsiNetworkCommand(), with data
+// phases served from memory buffers.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Frame source and sink:
+//   "none"        nothing is received, sent frames are only counted
+//   "tap:NAME"    Linux TAP interface, e.g. "tap:tap0" (needs CAP_NET_ADMIN)
+//   "pcap:FILE"   replay frames from a pcap capture as received traffic
+// Returns false on error.
+bool network_host_open(const char *spec);
+
+// Also write all frames sent by network.c to a pcap file
+bool network_host_open_output(const char *path);
+
+void network_host_close(void);
+
+struct network_host_options {
+    int rx_burst;           // frames received per platform_network_poll()
+    bool rx_paced;          // replay pcap frames at their captured times
+    int tx_busy_pct;        // percentage of sends that report a busy radio
+};
+extern struct network_host_options g_network_host_options;
+
+struct network_host_counters {
+    uint32_t rx_frames;     // frames passed to scsiNetworkEnqueue()
+    uint32_t rx_remaining;  // pcap frames not yet replayed
+    uint32_t tx_frames;     // frames accepted by platform_network_send()
+    uint32_t tx_busy;       // simulated busy radio
+};
+extern struct network_host_counters g_network_host_counters;
+
+// Run a single 6-byte CDB through scsiNetworkCommand().
+// Data-out bytes are taken from out, data-in bytes are stored to in.
+// Returns SCSI status byte, *inLen is set to the number of data-in bytes.
+int network_host_command(const uint8_t *cdb,
+    const uint8_t *out, uint32_t outLen,
+    uint8_t *in, uint32_t inMax, uint32_t *inLen);
@@ -0,0 +1,230 @@
+#include "network_queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Unit test helpers */
+#define COMMENT(x) printf("\n----" x "----\n");
+#define TEST(x) \
+    if (!(x)) { \
+        fprintf(stderr, "\033[31;1mFAILED:\033[22;39m %s:%d %s\n", __FILE__, __LINE__, #x); \
+        status = false; \
+    } else { \
+        printf("\033[32;1mOK:\033[22;39m %s\n", #x); \
+    }
+
+static uint32_t g_ring[20 * (1520 + 4) / 4];
+
+static void fill_packet(uint8_t *buf, uint16_t len, uint32_t seq)
+{
+    for (uint16_t i = 0; i < len; i++)
+    {
+        buf[i] = (uint8_t)(seq * 31 + i);
+    }
+}
+
+static bool check_packet(const uint8_t *buf, uint16_t len, uint32_t seq)
+{
+    for (uint16_t i = 0; i < len; i++)
+    {
+        if (buf[i] != (uint8_t)(seq * 31 + i)) return false;
+    }
+    return true;
+}
+
+bool test_basic()
+{
+    bool status = true;
+    struct network_queue q;
+    uint8_t pkt[1520];
+    uint16_t len = 0;
+
+    COMMENT("Empty queue");
+    network_queue_init(&q, (uint8_t*)g_ring, 4096);
+    TEST(network_queue_empty(&q));
+    TEST(network_queue_count(&q) == 0);
+    TEST(network_queue_peek(&q, &len, NULL) == NULL);
+
+    COMMENT("Packets come out in order");
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        fill_packet(pkt, 100 + i, i);
+        TEST(network_queue_push(&q, pkt, 100 + i, 0));
+    }
+    TEST(network_queue_count(&q) == 3);
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        const uint8_t *p = network_queue_peek(&q, &len, NULL);
+        TEST(p != NULL && len == 100 + i && check_packet(p, len, i));
+        network_queue_pop(&q);
+    }
+    TEST(network_queue_empty(&q));
+    TEST(network_queue_count(&q) == 0);
+
+    COMMENT("Reserve and commit shorter packet");
+    uint8_t *dst = network_queue_reserve(&q, 1520);
+    TEST(dst != NULL);
+    fill_packet(dst, 60, 7);
+    network_queue_commit(&q, 60, 0);
+    const uint8_t *p = network_queue_peek(&q, &len, NULL);
+    TEST(p == dst && len == 60 && check_packet(p, len, 7));
+    network_queue_pop(&q);
+
+    COMMENT("Oversized packet is counted as size drop");
+    network_queue_init(&q, (uint8_t*)g_ring, 1024);
+    TEST(!network_queue_push(&q, pkt, 1500, 0));
+    TEST(q.dropped_size == 1 && q.dropped_full == 0);
+
+    COMMENT("Clear empties the queue");
+    TEST(network_queue_push(&q, pkt, 100, 0));
+    network_queue_clear(&q);
+    TEST(network_queue_empty(&q));
+    TEST(network_queue_count(&q) == 0);
+
+    COMMENT("Discard drops packets across the wrap and keeps producer state");
+    for (int i = 0; i < 8; i++)
+    {
+        TEST(network_queue_push(&q, pkt, 200, 0));
+        if (i >= 2) network_queue_pop(&q);
+    }
+    uint32_t head = q.head;
+    network_queue_discard(&q);
+    TEST(network_queue_empty(&q));
+    TEST(network_queue_count(&q) == 0);
+    TEST(q.head == head && q.tail == head);
+    TEST(network_queue_push(&q, pkt, 100, 0));
+    TEST(network_queue_count(&q) == 1);
+
+    return status;
+}
+
+bool test_capacity()
+{
+    bool status = true;
+    struct network_queue q;
+    uint8_t pkt[1520];
+
+    COMMENT("Default ring size holds as many full frames as the old 20 slot queue");
+    network_queue_init(&q, (uint8_t*)g_ring, sizeof(g_ring));
+    int count = 0;
+    while (network_queue_push(&q, pkt, 1520, 0)) count++;
+    TEST(count == 19);
+    TEST(q.dropped_full == 1);
+    TEST(q.high_water == 19);
+
+    COMMENT("Same ring holds many more small frames");
+    network_queue_init(&q, (uint8_t*)g_ring, sizeof(g_ring));
+    count = 0;
+    while (network_queue_push(&q, pkt, 64, 0)) count++;
+    TEST(count >= 400);
+    TEST(network_queue_count(&q) == (uint32_t)count);
+
+    COMMENT("Full ring keeps the oldest packet intact");
+    network_queue_init(&q, (uint8_t*)g_ring, 1024);
+    uint32_t seq = 0;
+    fill_packet(pkt, 200, seq);
+    while (network_queue_push(&q, pkt, 200, 0)) fill_packet(pkt, 200, ++seq);
+    uint16_t len;
+    const uint8_t *p = network_queue_peek(&q, &len, NULL);
+    TEST(p != NULL && len == 200 && check_packet(p, len, 0));
+    TEST(q.dropped_full == 1);
+    TEST(!network_queue_has_room(&q, 200));
+    TEST(q.dropped_full == 1);
+    network_queue_pop(&q);
+    TEST(network_queue_has_room(&q, 100));
+
+    return status;
+}
+
+bool test_wraparound()
+{
+    bool status = true;
+    struct network_queue q;
+    uint8_t pkt[1520];
+    uint16_t len;
+    const uint8_t *p;
+
+    COMMENT("Packet that does not fit at the end starts at offset 0");
+    network_queue_init(&q, (uint8_t*)g_ring, 1024);
+    TEST(network_queue_push(&q, pkt, 400, 0));
+    TEST(network_queue_push(&q, pkt, 400, 0));
+    network_queue_pop(&q);
+    fill_packet(pkt, 300, 1);
+    uint8_t *dst = network_queue_reserve(&q, 300);
+    TEST(dst == (uint8_t*)g_ring + 8);
+    memcpy(dst, pkt, 300);
+    network_queue_commit(&q, 300, 0);
+
+    p = network_queue_peek(&q, &len, NULL);
+    TEST(p != NULL && len == 400);
+    network_queue_pop(&q);
+    p = network_queue_peek(&q, &len, NULL);
+    TEST(p == (uint8_t*)g_ring + 8 && len == 300 && check_packet(p, len, 1));
+    network_queue_pop(&q);
+    TEST(network_queue_empty(&q));
+
+    COMMENT("Randomized producer and consumer against reference FIFO");
+    network_queue_init(&q, (uint8_t*)g_ring, 4000);
+    uint16_t fifo_len[256];
+    uint32_t fifo_seq[256];
+    uint32_t fifo_head = 0, fifo_tail = 0;
+    uint32_t seq = 0, drops = 0;
+    bool all_ok = true, contiguous = true;
+    srand(1234);
+    for (int i = 0; i < 100000; i++)
+    {
+        if (rand() % 3 != 0)
+        {
+            uint16_t plen = (rand() % 2) ? (uint16_t)(1 + rand() % 100) : (uint16_t)(1 + rand() % 1520);
+            fill_packet(pkt, plen, seq);
+            if (network_queue_push(&q, pkt, plen, seq))
+            {
+                fifo_len[fifo_head % 256] = plen;
+                fifo_seq[fifo_head % 256] = seq;
+                fifo_head++;
+            }
+            else
+            {
+                drops++;
+            }
+            seq++;
+        }
+        else
+        {
+            uint32_t stamp = 0;
+            p = network_queue_peek(&q, &len, &stamp);
+            if (fifo_head == fifo_tail)
+            {
+                all_ok = all_ok && p == NULL;
+                continue;
+            }
+
+            all_ok = all_ok && p != NULL && len == fifo_len[fifo_tail % 256];
+            all_ok = all_ok && stamp == fifo_seq[fifo_tail % 256];
+            all_ok = all_ok && check_packet(p, len, fifo_seq[fifo_tail % 256]);
+            contiguous = contiguous && p + 64 <= (uint8_t*)g_ring + 8000;
+            network_queue_pop(&q);
+            fifo_tail++;
+        }
+        all_ok = all_ok && network_queue_count(&q) == fifo_head - fifo_tail;
+    }
+    TEST(all_ok);
+    TEST(contiguous);
+    TEST(drops > 0 && q.dropped_full == drops);
+    TEST(q.pushed == fifo_head);
+
+    return status;
+}
+
+int main()
+{
+    if (test_basic() && test_capacity() && test_wraparound())
+    {
+        return 0;
+    }
+    else
+    {
+        printf("Some tests failed\n");
+        return 1;
+    }
+}
@@ -57,6 +57,7 @@
 #include "BlueSCSI_log_trace.h"
 #include "BlueSCSI_disk.h"
 #include "BlueSCSI_initiator.h"
+#include "BlueSCSI_timeline.h"
 #include "ROMDrive.h"
 
 SdFs SD;
@@ -97,6 +98,85 @@ extern "C" void s2s_ledOff()
 /* Log saving */
 /**************/
 
+// The log file is preallocated as a contiguous region at boot and written
+// as raw sectors, which avoids FAT updates and SdFat buffering when saving.
+// First sector is a text header telling where the next write goes, the rest
+// of the file is used as a circular buffer. If the file cannot be allocated
+// contiguously, saving falls back to normal appends through SdFat.
+static struct {
+  bool raw;               // Raw sector mode active
+  uint32_t header_sector; // First sector of log file
+  uint32_t data_sectors;  // Number of sectors in circular area
+  uint32_t write_offset;  // Byte offset of next write in circular area
+  uint32_t wraps;         // Number of times circular area has wrapped
+  uint32_t sector_buf[SD_SECTOR_SIZE / 4]; // Current partially filled sector
+} g_logsave;
+
+// Called only at sector boundaries, when the sector buffer is free
+static bool write_logfile_header()
+{
+  char *header = (char*)g_logsave.sector_buf;
+  memset(header, ' ', SD_SECTOR_SIZE);
+  int len = snprintf(header, SD_SECTOR_SIZE,
+    "BlueSCSI log, circular buffer of %lu bytes starting at byte 512. "
+    "Next write offset %lu, wrapped %lu times.",
+    (unsigned long)g_logsave.data_sectors * SD_SECTOR_SIZE,
+    (unsigned long)g_logsave.write_offset, (unsigned long)g_logsave.wraps);
+  header[len] = ' ';
+  header[SD_SECTOR_SIZE - 1] = '\n';
+  return SD.card()->writeSectors(g_logsave.header_sector, (const uint8_t*)header, 1);
+}
+
+static void discard_logfile_raw(const char *reason);
+
+// Append text to circular log area, writing at most max_sectors sectors.
+// Returns number of bytes consumed.
+static uint32_t write_logfile_raw(const char *data, uint32_t len, int max_sectors)
+{
+  uint8_t *buf = (uint8_t*)g_logsave.sector_buf;
+  uint32_t consumed = 0;
+
+  while (consumed < len && max_sectors > 0)
+  {
+    uint32_t offset = g_logsave.write_offset % SD_SECTOR_SIZE;
+    uint32_t count = SD_SECTOR_SIZE - offset;
+    if (count > len - consumed) count = len - consumed;
+    memcpy(buf + offset, data + consumed, count);
+    consumed += count;
+
+    // Pad the unused part of the sector, it gets rewritten on next save
+    memset(buf + offset + count, ' ', SD_SECTOR_SIZE - offset - count);
+
+    uint32_t sector = g_logsave.header_sector + 1 + g_logsave.write_offset / SD_SECTOR_SIZE;
+    if (!SD.card()->writeSectors(sector, buf, 1))
+    {
+      log("Writing log sector ", (int)sector, " failed");
+      discard_logfile_raw("sector write failed");
+      return consumed;
+    }
+    max_sectors--;
+
+    g_logsave.write_offset += count;
+    if (g_logsave.write_offset % SD_SECTOR_SIZE == 0)
+    {
+      // Sector complete, move on and update header
+      if (g_logsave.write_offset >= g_logsave.data_sectors * SD_SECTOR_SIZE)
+      {
+        g_logsave.write_offset = 0;
+        g_logsave.wraps++;
+      }
+      if (!write_logfile_header())
+      {
+        discard_logfile_raw("header write failed");
+        return consumed;
+      }
+      max_sectors--;
+    }
+  }
+
+  return consumed;
+}
+
 void save_logfile(bool always = false)
 {
   static uint32_t prev_log_pos = 0;
@@ -107,29 +187,122 @@ void save_logfile(bool always = false)
   if (loglen != prev_log_len && g_sdcard_present)
   {
     // When debug is off, save log at most every LOG_SAVE_INTERVAL_MS
-    // When debug is on, save after every SCSI command.
+    // When debug is on, save whenever there are new messages.
     if (always || g_log_debug || (LOG_SAVE_INTERVAL_MS > 0 && (uint32_t)(millis() - prev_log_save) > LOG_SAVE_INTERVAL_MS))
     {
-      g_logfile.write(log_get_buffer(&prev_log_pos));
-      g_logfile.flush();
+      if (g_logsave.raw)
+      {
+        // Limit the number of sectors written per call so that the
+        // bus is not left unattended for long. Remaining data is
+        // written on the next call.
+        int max_sectors = always ? INT32_MAX : LOG_SAVE_MAX_SECTORS;
+        uint32_t available = 0;
+        uint32_t pos = prev_log_pos;
+        const char *data = log_get_buffer(&pos, &available);
+        uint32_t consumed = write_logfile_raw(data, available, max_sectors);
+        prev_log_pos = pos - (available - consumed);
+        if (!g_logsave.raw)
+        {
+          // Circular log was dropped, start the plain file from the
+          // oldest message still in the log buffer.
+          prev_log_pos = 0;
+        }
+        else if (prev_log_pos == loglen)
+        {
+          prev_log_len = loglen;
+        }
+      }
+      else
+      {
+        g_logfile.write(log_get_buffer(&prev_log_pos));
+        g_logfile.flush();
+        prev_log_len = loglen;
+      }
 
-      prev_log_len = loglen;
       prev_log_save = millis();
     }
   }
 }
 
+// Drop the circular log so that normal file writes start from an empty file
+static void discard_logfile_raw(const char *reason)
+{
+  g_logsave.raw = false;
+  log("Not using circular " LOGFILE " (", reason, "), using normal file writes");
+  g_logfile.seekSet(0);
+  g_logfile.truncate();
+  g_logfile.flush();
+}
+
+// Preallocate the log file and set up raw sector access to it
+static bool init_logfile_raw()
+{
+  g_logsave.raw = false;
+  if (!g_logfile.preAllocate(LOG_FILE_SIZE))
+  {
+    log("Could not preallocate " LOGFILE ", using normal file writes");
+    return false;
+  }
+
+  // Fill the file through the file system so that the whole length is
+  // valid data. SdFat cannot seek past the end of file, so the last byte
+  // cannot simply be written after preallocation.
+  uint8_t *buf = (uint8_t*)g_logsave.sector_buf;
+  memset(buf, ' ', SD_SECTOR_SIZE);
+  buf[SD_SECTOR_SIZE - 1] = '\n';
+  for (uint32_t i = 0; i < LOG_FILE_SIZE / SD_SECTOR_SIZE; i++)
+  {
+    if (g_logfile.write(buf, SD_SECTOR_SIZE) != SD_SECTOR_SIZE)
+    {
+      discard_logfile_raw("write failed");
+      return false;
+    }
+  }
+
+  if (!g_logfile.flush() || g_logfile.fileSize() != LOG_FILE_SIZE)
+  {
+    discard_logfile_raw("wrong file size");
+    return false;
+  }
+
+  uint32_t begin = 0, end = 0;
+  if (!g_logfile.contiguousRange(&begin, &end) || end + 1 - begin < LOG_FILE_SIZE / SD_SECTOR_SIZE)
+  {
+    discard_logfile_raw("not contiguous");
+    return false;
+  }
+
+  g_logsave.header_sector = begin;
+  g_logsave.data_sectors = LOG_FILE_SIZE / SD_SECTOR_SIZE - 1;
+  g_logsave.write_offset = 0;
+  g_logsave.wraps = 0;
+  if (!write_logfile_header())
+  {
+    discard_logfile_raw("header write failed");
+    return false;
+  }
+
+  g_logsave.raw = true;
+  return true;
+}
+
 void init_logfile()
 {
   static bool first_open_after_boot = true;
 
-  bool truncate = first_open_after_boot;
-  int flags = O_WRONLY | O_CREAT | (truncate ? O_TRUNC : O_APPEND);
+  // The circular log is recreated on boot and when SD card is reinserted.
+  // If it cannot be set up, fall back to appending after reinsertion.
+  bool truncate = first_open_after_boot || g_logsave.raw;
+  int flags = O_RDWR | O_CREAT | (truncate ? O_TRUNC : O_APPEND);
   g_logfile = SD.open(LOGFILE, flags);
   if (!g_logfile.isOpen())
   {
     log("Failed to open log file: ", SD.sdErrorCode());
   }
+  else if (truncate)
+  {
+    init_logfile_raw();
+  }
   save_logfile(true);
 
   first_open_after_boot = false;
@@ -506,6 +679,7 @@ static void reinitSCSI()
   {
     g_test_mode = true;
   }
+  g_timeline_enabled = ini_getbool("SCSI", "Timeline", 0, CONFIGFILE);
 
 #ifdef PLATFORM_HAS_INITIATOR_MODE
   if (platform_is_initiator_mode_enabled())
@@ -643,6 +817,7 @@ extern "C" void bluescsi_setup(void)
 
   log(" ");
   log("Initialization complete!");
+  g_log_immediate = LOG_IMMEDIATE;
 
   if (g_sdcard_present)
   {
@@ -732,17 +907,22 @@ extern "C" void bluescsi_main_loop(void)
     scsiDiskPoll();
     scsiLogPhaseChange(scsiDev.phase);
 
-    // Save log periodically during status phase if there are new messages.
-    // In debug mode, also save every 2 seconds if no SCSI requests come in.
-    // SD card writing takes a while, during which the code can't handle new
-    // SCSI requests, so normally we only want to save during a phase where
-    // the host is waiting for us. But for debugging issues where no requests
-    // come through or a request hangs, it's useful to force saving of log.
-    if (scsiDev.phase == STATUS || (g_log_debug && (uint32_t)(millis() - last_request_time) > 2000))
+    // Save log periodically when the bus is free and there are new messages.
+    // Saving writes a few raw sectors at most, so it does not delay the
+    // response to the next selection noticeably. In debug mode, also save
+    // every 2 seconds even if the bus is busy. For debugging issues where a
+    // request hangs, it's useful to force saving of log.
+    if (scsiDev.phase == BUS_FREE || (g_log_debug && (uint32_t)(millis() - last_request_time) > 2000))
     {
       save_logfile();
       last_request_time = millis();
     }
+
+    // Timeline dump is deferred until the host has released the bus
+    if (unlikely(g_timeline_dump_requested) && scsiDev.phase == BUS_FREE && g_sdcard_present)
+    {
+      timeline_save();
+    }
   }
 
   if (g_sdcard_present)
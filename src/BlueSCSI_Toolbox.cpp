@@ -21,6 +21,7 @@
 #include "BlueSCSI_cdrom.h"
 #include "BlueSCSI_log.h"
 #include "BlueSCSI_config.h"
+#include "BlueSCSI_timeline.h"
 #include <minIni.h>
 #include <SdFat.h>
 extern "C" {
@@ -335,6 +336,18 @@ void onToggleDebug()
     }
 }
 
+void onDumpTimeline()
+{
+    // Writing to SD card here would show up in the timeline itself,
+    // so only flag the request and let the main loop save it once the bus is free.
+    if (!g_timeline_enabled)
+    {
+        log("Timeline dump requested but Timeline is not enabled in " CONFIGFILE);
+    }
+    g_timeline_dump_requested = g_timeline_enabled;
+    scsiDev.phase = STATUS;
+}
+
 extern "C" int scsiBlueSCSIToolboxCommand()
 {
     int commandHandled = 1;
@@ -399,6 +412,10 @@ extern "C" int scsiBlueSCSIToolboxCommand()
         snprintf(img_dir, sizeof(img_dir), CD_IMG_DIR, (int)img.scsiId & S2S_CFG_TARGET_ID_BITS);
         doCountFiles(img_dir);
     }
+    else if (unlikely(command == BLUESCSI_TOOLBOX_DUMP_TIMELINE))
+    {
+        onDumpTimeline();
+    }
     else
     {
         commandHandled = 0;
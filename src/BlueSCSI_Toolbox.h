@@ -36,4 +36,5 @@
 #define BLUESCSI_TOOLBOX_SET_NEXT_CD    0xD8
 #define BLUESCSI_TOOLBOX_LIST_DEVICES   0xD9
 #define BLUESCSI_TOOLBOX_COUNT_CDS      0xDA
+#define BLUESCSI_TOOLBOX_DUMP_TIMELINE  0xDB
 #define OPEN_RETRO_SCSI_TOO_MANY_FILES 0x0001
\ No newline at end of file
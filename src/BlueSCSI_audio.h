@@ -75,12 +75,27 @@ bool audio_is_playing(uint8_t id);
  * \param owner  The SCSI ID that initiated this playback operation.
  * \param img    Pointer to the image containing PCM samples to play.
  * \param start  Byte offset within file where playback will begin, inclusive.
- * \param end    Byte offset within file where playback will end, exclusive.
+ * \param end    Byte offset where playback will end, exclusive. If this is
+ *               beyond the end of file, playback continues from the file
+ *               given by cdromGetNextAudioFile().
  * \param swap   If false, little-endian sample order, otherwise big-endian.
  * \return       True if successful, false otherwise.
+ *
+ * Playback reads through a private copy of the image handle, so SCSI
+ * commands may keep using img while audio is playing.
  */
 bool audio_play(uint8_t owner, ImageBackingStore* img, uint64_t start, uint64_t end, bool swap);
 
+/**
+ * Gets the byte offset of the samples currently being output. After playback
+ * has continued to another file, this counts on from the end of the previous.
+ *
+ * \param id   The SCSI ID to query.
+ * \param pos  Set to the current playback offset.
+ * \return     True if the ID is playing or paused, false otherwise.
+ */
+bool audio_get_file_position(uint8_t id, uint64_t *pos);
+
 /**
  * Pauses audio playback. This may be delayed slightly to allow sample buffers
  * to purge.
@@ -145,4 +160,16 @@ uint16_t audio_get_channel(uint8_t id);
  * \param id    SCSI ID to set channel information for.
  * \param chn   The new channel information.
  */
-void audio_set_channel(uint8_t id, uint16_t chn);
\ No newline at end of file
+void audio_set_channel(uint8_t id, uint16_t chn);
+
+/**
+ * Called by the audio subsystem when playback reaches the end of the current
+ * file before the requested end, as happens with CD images that store each
+ * track in a file of its own. Implemented by the CD-ROM code.
+ *
+ * \param id     The SCSI ID playing audio.
+ * \param img    Set to the image to continue playback from.
+ * \param start  Set to the byte offset within img where playback continues.
+ * \return       True if playback continues, false if it ends.
+ */
+bool cdromGetNextAudioFile(uint8_t id, ImageBackingStore **img, uint64_t *start);
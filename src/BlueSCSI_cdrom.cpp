@@ -33,6 +33,7 @@
 #include "BlueSCSI_config.h"
 #include "BlueSCSI_cdrom.h"
 #include <CUEParser.h>
+#include <CDSector.h>
 #include <assert.h>
 #ifdef ENABLE_AUDIO_OUTPUT
 #include "BlueSCSI_audio.h"
@@ -255,14 +256,11 @@ static int32_t MSF2LBA(uint8_t m, uint8_t s, uint8_t f, bool relative)
 }
 
 // Gets the LBA position of the lead-out for the current image
-static uint32_t getLeadOutLBA(const CUETrackInfo* lasttrack)
+static uint32_t getLeadOutLBA(const image_config_t &img)
 {
-    if (lasttrack != nullptr && lasttrack->track_number != 0)
+    if (img.cuetrackcount > 0)
     {
-        image_config_t &img = *(image_config_t*)scsiDev.target->cfg;
-        uint32_t lastTrackBlocks = (img.file.size() - lasttrack->file_offset)
-                / lasttrack->sector_length;
-        return lasttrack->data_start + lastTrackBlocks;
+        return img.cueleadout;
     }
     else
     {
@@ -454,32 +452,44 @@ void doReadTrackInformationSimple(bool track, uint32_t lba, uint16_t allocationL
 /* TOC generation from cue sheet */
 /*********************************/
 
+// Track info in case we have no .cue file
+static const CUETrackEntry g_default_track = {
+    0, // file_offset
+    0, // track_start
+    0, // data_start
+    2048, // sector_length
+    1, // track_number
+    CUETrack_MODE1_2048,
+    CUEFile_BINARY,
+    0 // file_index
+};
+
+// READ TOC responses rendered from the track table of one disc.
+// Shared by all targets, rebuilt when another target or a new disc is queried.
+static struct {
+    uint8_t target; // 0xFF if empty
+    uint8_t trackcount;
+    uint8_t toc[2][8 * (CDROM_MAX_TRACKS + 1)]; // Format 0 descriptors and lead-out, [MSF]
+    uint16_t fulltoc_len;
+    uint8_t fulltoc[2][4 + 11 * (3 + CDROM_MAX_TRACKS)]; // Format 2 response, [useBCD]
+} g_cdrom_toc = {0xFF};
+
 // Fetch track info based on LBA
-static void getTrackFromLBA(CUEParser &parser, uint32_t lba, CUETrackInfo *result)
+static const CUETrackEntry *getTrackFromLBA(image_config_t &img, uint32_t lba)
 {
-    // Track info in case we have no .cue file
-    result->file_mode = CUEFile_BINARY;
-    result->track_mode = CUETrack_MODE1_2048;
-    result->sector_length = 2048;
-    result->track_number = 1;
-
-    const CUETrackInfo *tmptrack;
-    while ((tmptrack = parser.next_track()) != NULL)
+    int idx = cue_find_track(img.cuetracks, img.cuetrackcount, lba, img.cuelasttrack);
+    if (idx < 0)
     {
-        if (tmptrack->track_start <= lba)
-        {
-            *result = *tmptrack;
-        }
-        else
-        {
-            break;
-        }
+        return &g_default_track;
     }
+
+    img.cuelasttrack = idx;
+    return &img.cuetracks[idx];
 }
 
 // Format track info read from cue sheet into the format used by ReadTOC command.
 // Refer to T10/1545-D MMC-4 Revision 5a, "Response Format 0000b: Formatted TOC"
-static void formatTrackInfo(const CUETrackInfo *track, uint8_t *dest, bool use_MSF_time)
+static void formatTrackInfo(const CUETrackEntry *track, uint8_t *dest, bool use_MSF_time)
 {
     uint8_t control_adr = 0x14; // Digital track
 
@@ -512,6 +522,7 @@ static void formatTrackInfo(const CUETrackInfo *track, uint8_t *dest, bool use_M
 // Load data from CUE sheet for the given device,
 // using the second half of scsiDev.data buffer for temporary storage.
 // Returns false if no cue sheet or it could not be opened.
+// Only used at image load time, command handlers use the parsed track table.
 static bool loadCueSheet(image_config_t &img, CUEParser &parser)
 {
     if (!img.cuesheetfile.isOpen())
@@ -535,48 +546,34 @@ static bool loadCueSheet(image_config_t &img, CUEParser &parser)
     return true;
 }
 
+static void renderTOC(image_config_t &img);
+
 static void doReadTOC(bool MSF, uint8_t track, uint16_t allocationLength)
 {
     image_config_t &img = *(image_config_t*)scsiDev.target->cfg;
-    CUEParser parser;
-    if (!loadCueSheet(img, parser))
+    if (img.cuetrackcount == 0)
     {
         // No CUE sheet, use hardcoded data
         return doReadTOCSimple(MSF, track, allocationLength);
     }
+    renderTOC(img);
 
-    // Format track info
-    uint8_t *trackdata = &scsiDev.data[4];
-    int trackcount = 0;
-    int firsttrack = -1;
-    CUETrackInfo lasttrack = {0};
-    const CUETrackInfo *trackinfo;
-    while ((trackinfo = parser.next_track()) != NULL)
+    // Tracks are in ascending order, so the response is the
+    // descriptors starting from the requested track and the lead-out.
+    int first = 0;
+    while (first < img.cuetrackcount && img.cuetracks[first].track_number < track)
     {
-        if (firsttrack < 0) firsttrack = trackinfo->track_number;
-        lasttrack = *trackinfo;
-
-        if (track <= trackinfo->track_number)
-        {
-            formatTrackInfo(trackinfo, &trackdata[8 * trackcount], MSF);
-            trackcount += 1;
-        }
+        first++;
     }
-
-    // Format lead-out track info
-    CUETrackInfo leadout = {};
-    leadout.track_number = 0xAA;
-    leadout.track_mode = (lasttrack.track_number != 0) ? lasttrack.track_mode : CUETrack_MODE1_2048;
-    leadout.data_start = getLeadOutLBA(&lasttrack);
-    formatTrackInfo(&leadout, &trackdata[8 * trackcount], MSF);
-    trackcount += 1;
+    int trackcount = g_cdrom_toc.trackcount - first + 1;
+    memcpy(&scsiDev.data[4], &g_cdrom_toc.toc[MSF][8 * first], 8 * trackcount);
 
     // Format response header
     uint16_t toc_length = 2 + trackcount * 8;
     scsiDev.data[0] = toc_length >> 8;
     scsiDev.data[1] = toc_length & 0xFF;
-    scsiDev.data[2] = firsttrack;
-    scsiDev.data[3] = lasttrack.track_number;
+    scsiDev.data[2] = img.cuetracks[0].track_number;
+    scsiDev.data[3] = img.cuetracks[img.cuetrackcount - 1].track_number;
 
     if (track != 0xAA && trackcount < 2)
     {
@@ -603,23 +600,19 @@ static void doReadTOC(bool MSF, uint8_t track, uint16_t allocationLength)
 static void doReadSessionInfo(bool msf, uint16_t allocationLength)
 {
     image_config_t &img = *(image_config_t*)scsiDev.target->cfg;
-    CUEParser parser;
-    if (!loadCueSheet(img, parser))
+    if (img.cuetrackcount == 0)
     {
         // No CUE sheet, use hardcoded data
         return doReadSessionInfoSimple(msf, allocationLength);
     }
+    renderTOC(img);
 
     uint32_t len = sizeof(SessionTOC);
     memcpy(scsiDev.data, SessionTOC, len);
 
     // Replace first track info in the session table
     // based on data from CUE sheet.
-    const CUETrackInfo *trackinfo = parser.next_track();
-    if (trackinfo)
-    {
-        formatTrackInfo(trackinfo, &scsiDev.data[4], false);
-    }
+    memcpy(&scsiDev.data[4], g_cdrom_toc.toc[msf], 8);
 
     if (len > allocationLength)
     {
@@ -631,7 +624,7 @@ static void doReadSessionInfo(bool msf, uint16_t allocationLength)
 
 // Format track info read from cue sheet into the format used by ReadFullTOC command.
 // Refer to T10/1545-D MMC-4 Revision 5a, "Response Format 0010b: Raw TOC"
-static void formatRawTrackInfo(const CUETrackInfo *track, uint8_t *dest, bool useBCD)
+static void formatRawTrackInfo(const CUETrackEntry *track, uint8_t *dest, bool useBCD)
 {
     uint8_t control_adr = 0x14; // Digital track
 
@@ -660,11 +653,80 @@ static void formatRawTrackInfo(const CUETrackInfo *track, uint8_t *dest, bool us
     }
 }
 
+// Render the READ TOC responses of the current disc, unless already cached
+static void renderTOC(image_config_t &img)
+{
+    uint8_t target = img.scsiId & S2S_CFG_TARGET_ID_BITS;
+    if (g_cdrom_toc.target == target)
+    {
+        return;
+    }
+
+    const CUETrackEntry *firsttrack = &img.cuetracks[0];
+    const CUETrackEntry *lasttrack = &img.cuetracks[img.cuetrackcount - 1];
+    CUETrackEntry leadout = {};
+    leadout.track_number = 0xAA;
+    leadout.track_mode = lasttrack->track_mode;
+    leadout.data_start = getLeadOutLBA(img);
+
+    for (int form = 0; form < 2; form++)
+    {
+        // Formatted TOC, form selects MSF
+        uint8_t *toc = g_cdrom_toc.toc[form];
+        for (int i = 0; i < img.cuetrackcount; i++)
+        {
+            formatTrackInfo(&img.cuetracks[i], &toc[8 * i], form);
+        }
+        formatTrackInfo(&leadout, &toc[8 * img.cuetrackcount], form);
+
+        // Raw TOC, form selects BCD
+        // Take the beginning of the hardcoded TOC as base
+        uint8_t *fulltoc = g_cdrom_toc.fulltoc[form];
+        uint32_t len = 4 + 11 * 3; // Header, A0, A1, A2
+        memcpy(fulltoc, FullTOC, len);
+
+        // Add track descriptors
+        for (int i = 0; i < img.cuetrackcount; i++)
+        {
+            formatRawTrackInfo(&img.cuetracks[i], &fulltoc[len], form);
+            len += 11;
+        }
+
+        // First and last track numbers
+        fulltoc[12] = firsttrack->track_number;
+        if (firsttrack->track_mode == CUETrack_AUDIO)
+        {
+            fulltoc[5] = 0x10;
+        }
+        fulltoc[23] = lasttrack->track_number;
+        if (lasttrack->track_mode == CUETrack_AUDIO)
+        {
+            fulltoc[16] = 0x10;
+            fulltoc[27] = 0x10;
+        }
+
+        // Leadout track position
+        if (form) {
+            LBA2MSFBCD(leadout.data_start, &fulltoc[34], false);
+        } else {
+            LBA2MSF(leadout.data_start, &fulltoc[34], false);
+        }
+
+        // Correct the record length in header
+        uint16_t toclen = len - 2;
+        fulltoc[0] = toclen >> 8;
+        fulltoc[1] = toclen & 0xFF;
+        g_cdrom_toc.fulltoc_len = len;
+    }
+
+    g_cdrom_toc.trackcount = img.cuetrackcount;
+    g_cdrom_toc.target = target;
+}
+
 static void doReadFullTOC(uint8_t session, uint16_t allocationLength, bool useBCD)
 {
     image_config_t &img = *(image_config_t*)scsiDev.target->cfg;
-    CUEParser parser;
-    if (!loadCueSheet(img, parser))
+    if (img.cuetrackcount == 0)
     {
         // No CUE sheet, use hardcoded data
         return doReadFullTOCSimple(session, allocationLength, useBCD);
@@ -679,56 +741,10 @@ static void doReadFullTOC(uint8_t session, uint16_t allocationLength, bool useBC
         scsiDev.phase = STATUS;
         return;
     }
+    renderTOC(img);
 
-    // Take the beginning of the hardcoded TOC as base
-    uint32_t len = 4 + 11 * 3; // Header, A0, A1, A2
-    memcpy(scsiDev.data, FullTOC, len);
-
-    // Add track descriptors
-    int trackcount = 0;
-    int firsttrack = -1;
-    CUETrackInfo lasttrack = {0};
-    const CUETrackInfo *trackinfo;
-    while ((trackinfo = parser.next_track()) != NULL)
-    {
-        if (firsttrack < 0)
-        {
-            firsttrack = trackinfo->track_number;
-            if (trackinfo->track_mode == CUETrack_AUDIO)
-            {
-                scsiDev.data[5] = 0x10;
-            }
-        }
-        lasttrack = *trackinfo;
-
-        formatRawTrackInfo(trackinfo, &scsiDev.data[len], useBCD);
-        trackcount += 1;
-        len += 11;
-    }
-
-    // First and last track numbers
-    scsiDev.data[12] = firsttrack;
-    if (lasttrack.track_number != 0)
-    {
-        scsiDev.data[23] = lasttrack.track_number;
-        if (lasttrack.track_mode == CUETrack_AUDIO)
-        {
-            scsiDev.data[16] = 0x10;
-            scsiDev.data[27] = 0x10;
-        }
-    }
-
-    // Leadout track position
-    if (useBCD) {
-        LBA2MSFBCD(getLeadOutLBA(&lasttrack), &scsiDev.data[34], false);
-    } else {
-        LBA2MSF(getLeadOutLBA(&lasttrack), &scsiDev.data[34], false);
-    }
-
-    // Correct the record length in header
-    uint16_t toclen = len - 2;
-    scsiDev.data[0] = toclen >> 8;
-    scsiDev.data[1] = toclen & 0xFF;
+    uint32_t len = g_cdrom_toc.fulltoc_len;
+    memcpy(scsiDev.data, g_cdrom_toc.fulltoc[useBCD], len);
 
     if (len > allocationLength)
     {
@@ -753,15 +769,13 @@ void doReadHeader(bool MSF, uint32_t lba, uint16_t allocationLength)
 #endif
 
     uint8_t mode = 1;
-    CUEParser parser;
-    if (loadCueSheet(img, parser))
+    if (img.cuetrackcount > 0)
     {
         // Search the track with the requested LBA
-        CUETrackInfo trackinfo = {};
-        getTrackFromLBA(parser, lba, &trackinfo);
+        const CUETrackEntry *trackinfo = getTrackFromLBA(img, lba);
 
         // Track mode (audio / data)
-        if (trackinfo.track_mode == CUETrack_AUDIO)
+        if (trackinfo->track_mode == CUETrack_AUDIO)
         {
             scsiDev.data[0] = 0;
         }
@@ -798,8 +812,7 @@ void doReadHeader(bool MSF, uint32_t lba, uint16_t allocationLength)
 void doReadDiscInformation(uint16_t allocationLength)
 {
     image_config_t &img = *(image_config_t*)scsiDev.target->cfg;
-    CUEParser parser;
-    if (!loadCueSheet(img, parser))
+    if (img.cuetrackcount == 0)
     {
         // No CUE sheet, use hardcoded data
         return doReadDiscInformationSimple(allocationLength);
@@ -809,15 +822,9 @@ void doReadDiscInformation(uint16_t allocationLength)
     uint32_t len = sizeof(DiscInformation);
     memcpy(scsiDev.data, DiscInformation, len);
 
-    // Find first and last track number
-    int firsttrack = -1;
-    int lasttrack = -1;
-    const CUETrackInfo *trackinfo;
-    while ((trackinfo = parser.next_track()) != NULL)
-    {
-        if (firsttrack < 0) firsttrack = trackinfo->track_number;
-        lasttrack = trackinfo->track_number;
-    }
+    // First and last track number
+    int firsttrack = img.cuetracks[0].track_number;
+    int lasttrack = img.cuetracks[img.cuetrackcount - 1].track_number;
 
     scsiDev.data[3] = firsttrack;
     scsiDev.data[5] = firsttrack;
@@ -834,8 +841,7 @@ void doReadDiscInformation(uint16_t allocationLength)
 void doReadTrackInformation(bool track, uint32_t lba, uint16_t allocationLength)
 {
     image_config_t &img = *(image_config_t*)scsiDev.target->cfg;
-    CUEParser parser;
-    if (!loadCueSheet(img, parser))
+    if (img.cuetrackcount == 0)
     {
         // No CUE sheet, use hardcoded data
         return doReadTrackInformationSimple(track, lba, allocationLength);
@@ -845,40 +851,25 @@ void doReadTrackInformation(bool track, uint32_t lba, uint16_t allocationLength)
     uint32_t len = sizeof(TrackInformation);
     memcpy(scsiDev.data, TrackInformation, len);
 
-    // Step through the tracks until the one requested is found
-    // Result will be placed in mtrack for later use if found
-    bool trackfound = false;
+    // Step through the tracks until the one requested is found,
+    // track length extends to start of next track or lead-out.
+    const CUETrackEntry *mtrack = NULL;
     uint32_t tracklen = 0;
-    CUETrackInfo mtrack = {0};
-    const CUETrackInfo *trackinfo;
-    while ((trackinfo = parser.next_track()) != NULL)
-    {
-        if (mtrack.track_number != 0) // skip 1st track, just store later
-        {
-            if ((track && lba == mtrack.track_number)
-                || (!track && lba < trackinfo->data_start))
-            {
-                trackfound = true;
-                tracklen = trackinfo->data_start - mtrack.data_start;
-                break;
-            }
-        }
-        mtrack = *trackinfo;
-    }
-    // try the last track as a final attempt if no match found beforehand
-    if (!trackfound)
+    for (int i = 0; i < img.cuetrackcount; i++)
     {
-        uint32_t lastLba = getLeadOutLBA(&mtrack);
-        if ((track && lba == mtrack.track_number)
-            || (!track && lba < lastLba))
+        const CUETrackEntry *trackinfo = &img.cuetracks[i];
+        uint32_t end = (i + 1 < img.cuetrackcount) ? img.cuetracks[i + 1].data_start : getLeadOutLBA(img);
+        if ((track && lba == trackinfo->track_number)
+            || (!track && lba < end))
         {
-            trackfound = true;
-            tracklen = lastLba - mtrack.data_start;
+            mtrack = trackinfo;
+            tracklen = end - trackinfo->data_start;
+            break;
         }
     }
 
     // bail out if no match found
-    if (!trackfound)
+    if (mtrack == NULL)
     {
         scsiDev.status = CHECK_CONDITION;
         scsiDev.target->sense.code = ILLEGAL_REQUEST;
@@ -888,16 +879,16 @@ void doReadTrackInformation(bool track, uint32_t lba, uint16_t allocationLength)
     }
 
     // rewrite relevant bytes, starting with track number
-    scsiDev.data[3] = mtrack.track_number;
+    scsiDev.data[3] = mtrack->track_number;
 
     // track mode
-    if (mtrack.track_mode == CUETrack_AUDIO)
+    if (mtrack->track_mode == CUETrack_AUDIO)
     {
         scsiDev.data[5] = 0x00;
     }
 
     // track start
-    uint32_t start = mtrack.data_start;
+    uint32_t start = mtrack->data_start;
     scsiDev.data[8] = start >> 24;
     scsiDev.data[9] = start >> 16;
     scsiDev.data[10] = start >> 8;
@@ -909,7 +900,7 @@ void doReadTrackInformation(bool track, uint32_t lba, uint16_t allocationLength)
     scsiDev.data[26] = tracklen >> 8;
     scsiDev.data[27] = tracklen;
 
-    debuglog("------ Reporting track ", mtrack.track_number, ", start ", start,
+    debuglog("------ Reporting track ", mtrack->track_number, ", start ", start,
             ", length ", tracklen);
     if (len > allocationLength)
     {
@@ -1104,22 +1095,288 @@ void doGetConfiguration(uint8_t rt, uint16_t startFeature, uint16_t allocationLe
     scsiDev.phase = DATA_IN;
 }
 
+/*********************************************/
+/* Track data files for multi-FILE cue sheets */
+/*********************************************/
+
+// Tracks stored in other files than the image file itself are opened on demand.
+// The files are kept open together with their raw sector mapping in a small
+// cache shared by all targets. When a new file is needed, the least recently
+// used one is closed.
+static struct {
+    ImageBackingStore file;
+    bool valid;
+    uint8_t target;
+    uint8_t file_index;
+    uint32_t last_used;
+} g_cdrom_track_files[CDROM_FILE_CACHE_SIZE];
+static uint32_t g_cdrom_track_file_counter;
+
+// Find the name of Nth file referenced by tracks in the cue sheet
+static bool getCueFileName(image_config_t &img, int file_index, char *name)
+{
+    CUEParser parser;
+    if (!loadCueSheet(img, parser))
+    {
+        return false;
+    }
+
+    int index = -1;
+    char current[CUE_MAX_FILENAME + 1] = "";
+    const CUETrackInfo *trackinfo;
+    while ((trackinfo = parser.next_track()) != NULL)
+    {
+        if (index < 0 || strcmp(trackinfo->filename, current) != 0)
+        {
+            index++;
+            strcpy(current, trackinfo->filename);
+        }
+
+        if (index == file_index)
+        {
+            strcpy(name, current);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Get path of a file referenced by the cue sheet, relative to the cue sheet
+static void getCueFilePath(const image_config_t &img, const char *name, char *path, size_t pathlen)
+{
+    strlcpy(path, img.cuedir, pathlen);
+    strlcat(path, name, pathlen);
+}
+
+// Get the file containing data of the track, or NULL if it cannot be opened
+static ImageBackingStore *getTrackFile(image_config_t &img, const CUETrackEntry *track)
+{
+    if (track->file_index == 0)
+    {
+        return &img.file;
+    }
+
+    uint8_t target = img.scsiId & S2S_CFG_TARGET_ID_BITS;
+    int slot = 0;
+    for (int i = 0; i < CDROM_FILE_CACHE_SIZE; i++)
+    {
+        if (g_cdrom_track_files[i].valid &&
+            g_cdrom_track_files[i].target == target &&
+            g_cdrom_track_files[i].file_index == track->file_index)
+        {
+            g_cdrom_track_files[i].last_used = ++g_cdrom_track_file_counter;
+            return &g_cdrom_track_files[i].file;
+        }
+
+        if (!g_cdrom_track_files[slot].valid)
+        {
+            // Keep the free slot
+        }
+        else if (!g_cdrom_track_files[i].valid ||
+                 g_cdrom_track_files[i].last_used < g_cdrom_track_files[slot].last_used)
+        {
+            slot = i;
+        }
+    }
+
+    char filename[CUE_MAX_FILENAME + 1];
+    char path[MAX_FILE_PATH + 1];
+    if (!getCueFileName(img, track->file_index, filename))
+    {
+        log("---- Track ", track->track_number, " file not found in cue sheet");
+        return NULL;
+    }
+    getCueFilePath(img, filename, path, sizeof(path));
+
+#if ENABLE_AUDIO_OUTPUT
+    // Playback may be streaming from the file that is going to be closed
+    if (g_cdrom_track_files[slot].valid && audio_is_playing(g_cdrom_track_files[slot].target))
+    {
+        audio_stop(g_cdrom_track_files[slot].target);
+    }
+#endif
+
+    g_cdrom_track_files[slot].file.close();
+    g_cdrom_track_files[slot].file = ImageBackingStore(path, 2048);
+    g_cdrom_track_files[slot].valid = g_cdrom_track_files[slot].file.isOpen();
+    g_cdrom_track_files[slot].target = target;
+    g_cdrom_track_files[slot].file_index = track->file_index;
+    g_cdrom_track_files[slot].last_used = ++g_cdrom_track_file_counter;
+
+    if (!g_cdrom_track_files[slot].valid)
+    {
+        log("---- Failed to open track file ", path);
+        return NULL;
+    }
+
+    debuglog("------ Opened track file ", path);
+    return &g_cdrom_track_files[slot].file;
+}
+
+void cdromCloseTrackFiles(image_config_t &img)
+{
+    uint8_t target = img.scsiId & S2S_CFG_TARGET_ID_BITS;
+    for (int i = 0; i < CDROM_FILE_CACHE_SIZE; i++)
+    {
+        if (g_cdrom_track_files[i].valid && g_cdrom_track_files[i].target == target)
+        {
+            g_cdrom_track_files[i].file.close();
+            g_cdrom_track_files[i].valid = false;
+        }
+    }
+}
+
 /****************************************/
 /* CUE sheet check at image load time   */
 /****************************************/
 
-bool cdromValidateCueSheet(image_config_t &img)
+static_assert(CDROM_MAX_TRACKS <= 255, "cuetrackcount is stored in uint8_t");
+
+// Track tables are needed only by CD-ROM targets with a cue sheet, so they
+// are kept in a pool instead of in image_config_t. By default there is one
+// per target, builds short on RAM can reduce CDROM_CUE_TABLES.
+static struct {
+    CUETrackEntry tracks[CDROM_MAX_TRACKS];
+    const image_config_t *owner;
+} g_cdrom_cue_tables[CDROM_CUE_TABLES];
+
+static CUETrackEntry *cdromAllocCueTable(image_config_t &img)
+{
+    for (int i = 0; i < CDROM_CUE_TABLES; i++)
+    {
+        if (g_cdrom_cue_tables[i].owner == NULL)
+        {
+            g_cdrom_cue_tables[i].owner = &img;
+            return g_cdrom_cue_tables[i].tracks;
+        }
+    }
+
+    return NULL;
+}
+
+void cdromReleaseCueTable(image_config_t &img)
+{
+    for (int i = 0; i < CDROM_CUE_TABLES; i++)
+    {
+        if (g_cdrom_cue_tables[i].owner == &img)
+        {
+            g_cdrom_cue_tables[i].owner = NULL;
+        }
+    }
+
+    img.cuetracks = NULL;
+    img.cuetrackcount = 0;
+}
+
+// LBA after the last sector of the file that contains the track
+static uint32_t getFileEndLBA(const CUETrackEntry *track, uint64_t file_size)
+{
+    uint32_t sector_length = track->sector_length ? track->sector_length : 2352;
+    if (file_size < track->file_offset)
+    {
+        return track->data_start;
+    }
+
+    return track->data_start + (file_size - track->file_offset) / sector_length;
+}
+
+bool cdromValidateCueSheet(image_config_t &img, const char *cuesheetname, const char *firstfile)
 {
+    cdromReleaseCueTable(img);
+    cdromCloseTrackFiles(img);
+    if (g_cdrom_toc.target == (img.scsiId & S2S_CFG_TARGET_ID_BITS))
+    {
+        g_cdrom_toc.target = 0xFF;
+    }
+
+    // Files referenced by the cue sheet are relative to its directory
+    const char *dirend = strrchr(cuesheetname, '/');
+    size_t dirlen = dirend ? (dirend - cuesheetname + 1) : 0;
+    if (dirlen >= sizeof(img.cuedir)) dirlen = 0;
+    memcpy(img.cuedir, cuesheetname, dirlen);
+    img.cuedir[dirlen] = '\0';
+
     CUEParser parser;
     if (!loadCueSheet(img, parser))
     {
         return false;
     }
 
+    img.cuetracks = cdromAllocCueTable(img);
+    if (img.cuetracks == NULL)
+    {
+        log("---- Only ", (int)CDROM_CUE_TABLES, " CD-ROM images with cue sheets are supported at a time, increase CDROM_CUE_TABLES");
+        return false;
+    }
+
+    // Times in the cue sheet are relative to start of each FILE,
+    // tracks in later files are offset by the length of earlier files.
     const CUETrackInfo *trackinfo;
+    char filename[CUE_MAX_FILENAME + 1] = "";
+    int file_index = -1;
+    uint32_t file_start = 0;
+    uint64_t file_size = 0;
     int trackcount = 0;
     while ((trackinfo = parser.next_track()) != NULL)
     {
+        if (trackcount >= CDROM_MAX_TRACKS)
+        {
+            log("---- Warning: cue sheet has more than ", (int)CDROM_MAX_TRACKS, " tracks, ignoring the rest");
+            break;
+        }
+
+        if (file_index < 0 || strcmp(trackinfo->filename, filename) != 0)
+        {
+            if (file_index >= 0)
+            {
+                file_start = getFileEndLBA(&img.cuetracks[trackcount - 1], file_size);
+            }
+
+            file_index++;
+            strcpy(filename, trackinfo->filename);
+
+            if (file_index == 0)
+            {
+                // First file is the image itself
+                if (firstfile && strcasecmp(filename, firstfile) != 0)
+                {
+                    log("---- Image is not the first file ", filename, " of the cue sheet");
+                    return false;
+                }
+                file_size = img.file.size();
+            }
+            else
+            {
+                char path[MAX_FILE_PATH + 1];
+                getCueFilePath(img, filename, path, sizeof(path));
+                FsFile file = SD.open(path, O_RDONLY);
+                if (!file.isOpen())
+                {
+                    log("---- Could not open track file ", path);
+                    return false;
+                }
+                file_size = file.size();
+                file.close();
+            }
+        }
+
+        if (trackinfo->file_offset > UINT32_MAX)
+        {
+            log("---- Track ", trackinfo->track_number, " starts beyond 4 GB in its file");
+            return false;
+        }
+
+        // Store the fields needed by command handlers
+        CUETrackEntry *entry = &img.cuetracks[trackcount];
+        entry->file_offset = trackinfo->file_offset;
+        entry->track_start = file_start + trackinfo->track_start;
+        entry->data_start = file_start + trackinfo->data_start;
+        entry->sector_length = trackinfo->sector_length;
+        entry->track_number = trackinfo->track_number;
+        entry->track_mode = trackinfo->track_mode;
+        entry->file_mode = trackinfo->file_mode;
+        entry->file_index = file_index;
         trackcount++;
 
         if (trackinfo->track_mode != CUETrack_AUDIO &&
@@ -1141,7 +1398,19 @@ bool cdromValidateCueSheet(image_config_t &img)
         return false;
     }
 
-    log("---- Cue sheet loaded with ", (int)trackcount, " tracks");
+    // Lead-out starts after the data of last track
+    img.cueleadout = getFileEndLBA(&img.cuetracks[trackcount - 1], file_size);
+    img.cuelasttrack = 0;
+    img.cuetrackcount = trackcount;
+
+    if (file_index > 0)
+    {
+        log("---- Cue sheet loaded with ", (int)trackcount, " tracks in ", file_index + 1, " files");
+    }
+    else
+    {
+        log("---- Cue sheet loaded with ", (int)trackcount, " tracks");
+    }
     return true;
 }
 
@@ -1158,6 +1427,7 @@ void cdromCloseTray(image_config_t &img)
         debuglog("------ CDROM close tray on ID ", (int)target);
         img.ejected = false;
         img.cdrom_events = 2; // New media
+        img.poll_ready = false;
 
         if (scsiDev.boardCfg.flags & S2S_CFG_ENABLE_UNIT_ATTENTION)
         {
@@ -1181,6 +1451,7 @@ void cdromPerformEject(image_config_t &img)
         debuglog("------ CDROM open tray on ID ", (int)target);
         img.ejected = true;
         img.cdrom_events = 3; // Media removal
+        img.poll_ready = false;
         switchNextImage(img); // Switch media for next time
     }
     else
@@ -1252,10 +1523,84 @@ static void doGetEventStatusNotification(bool immed)
     }
 }
 
+// Host drivers poll with TEST UNIT READY and GET EVENT STATUS NOTIFICATION
+// several times per second. Once a TEST UNIT READY has succeeded, the answer
+// stays the same until the media changes and pending events are reported
+// through the normal path, so these polls are answered before the rest of
+// the command dispatch. The latency target for these is below 32 us
+// command-to-status, as reported on LOG SENSE page 0x31.
+static const uint8_t g_gesn_no_event[4] = {
+    0, 2, // EventDataLength
+    0x00, // Media status events
+    0x04, // Supported events
+};
+
+static bool cdromFastPoll(image_config_t &img, uint8_t command)
+{
+    if (!img.poll_ready || img.cdrom_events)
+    {
+        return false;
+    }
+    else if (command == 0x00)
+    {
+        scsiDev.phase = STATUS;
+        return true;
+    }
+    else if (command == 0x4A && (scsiDev.cdb[1] & 1))
+    {
+        memcpy(scsiDev.data, g_gesn_no_event, sizeof(g_gesn_no_event));
+        scsiDev.dataLen = sizeof(g_gesn_no_event);
+        scsiDev.phase = DATA_IN;
+        return true;
+    }
+    return false;
+}
+
 /**************************************/
 /* CD-ROM audio playback              */
 /**************************************/
 
+#ifdef ENABLE_AUDIO_OUTPUT
+// Where the last playback started, to convert playback position back to LBA
+static struct {
+    uint32_t lba;
+    uint64_t offset;
+    uint16_t sector_length;
+    uint32_t file_end; // LBA after the file currently being played
+} g_cdrom_audio_start[8];
+
+// Playback of a multi-FILE image continues from the track that starts where
+// the current file ends
+bool cdromGetNextAudioFile(uint8_t id, ImageBackingStore **img, uint64_t *start)
+{
+    uint8_t target = id & S2S_CFG_TARGET_ID_BITS;
+    image_config_t &cfg = scsiDiskGetImageConfig(target);
+    uint32_t lba = g_cdrom_audio_start[target].file_end;
+    if (cfg.cuetrackcount == 0 || lba >= cfg.cueleadout)
+    {
+        return false;
+    }
+
+    const CUETrackEntry *trackinfo = getTrackFromLBA(cfg, lba);
+    if (trackinfo->track_start != lba || trackinfo->track_mode != CUETrack_AUDIO)
+    {
+        return false;
+    }
+
+    ImageBackingStore *file = getTrackFile(cfg, trackinfo);
+    if (!file)
+    {
+        return false;
+    }
+
+    debuglog("------ Audio playback continues to track ", trackinfo->track_number);
+    *img = file;
+    *start = trackinfo->file_offset;
+    g_cdrom_audio_start[target].file_end = getFileEndLBA(trackinfo, file->size());
+    return true;
+}
+#endif
+
 void cdromGetAudioPlaybackStatus(uint8_t *status, uint32_t *current_lba, bool current_only)
 {
     image_config_t &img = *(image_config_t*)scsiDev.target->cfg;
@@ -1274,6 +1619,19 @@ void cdromGetAudioPlaybackStatus(uint8_t *status, uint32_t *current_lba, bool cu
 #endif
     if (current_lba)
     {
+#ifdef ENABLE_AUDIO_OUTPUT
+        uint8_t target = img.scsiId & S2S_CFG_TARGET_ID_BITS;
+        uint64_t pos;
+        if (audio_get_file_position(target, &pos))
+        {
+            *current_lba = g_cdrom_audio_start[target].lba;
+            if (pos > g_cdrom_audio_start[target].offset)
+            {
+                *current_lba += (pos - g_cdrom_audio_start[target].offset) / g_cdrom_audio_start[target].sector_length;
+            }
+            return;
+        }
+#endif
         if (img.file.isOpen()) {
             *current_lba = img.file.position() / 2352;
         } else {
@@ -1289,6 +1647,12 @@ static void doPlayAudio(uint32_t lba, uint32_t length)
     image_config_t &img = *(image_config_t*)scsiDev.target->cfg;
     uint8_t target_id = img.scsiId & S2S_CFG_TARGET_ID_BITS;
 
+    if (lba == 0xFFFFFFFF)
+    {
+        // request to start playback from 'current position'
+        cdromGetAudioPlaybackStatus(NULL, &lba, true);
+    }
+
     // Per Annex C terminate playback immediately if already in progress on
     // the current target. Non-current targets may also get their audio
     // interrupted later due to hardware limitations
@@ -1304,26 +1668,19 @@ static void doPlayAudio(uint32_t lba, uint32_t length)
     }
 
     // if actual playback is requested perform steps to verify prior to playback
-    CUEParser parser;
-    if (loadCueSheet(img, parser))
+    if (img.cuetrackcount > 0)
     {
-        CUETrackInfo trackinfo = {};
-        getTrackFromLBA(parser, lba, &trackinfo);
+        const CUETrackEntry *trackinfo = getTrackFromLBA(img, lba);
+        ImageBackingStore *file = getTrackFile(img, trackinfo);
 
-        if (lba == 0xFFFFFFFF)
-        {
-            // request to start playback from 'current position'
-            lba = img.file.position() / 2352;
-        }
-
-        uint64_t offset = trackinfo.file_offset
-                + trackinfo.sector_length * (lba - trackinfo.track_start);
+        uint64_t offset = trackinfo->file_offset
+                + trackinfo->sector_length * (lba - trackinfo->track_start);
         debuglog("------ Play audio CD: ", (int)length, " sectors starting at ", (int)lba,
-           ", track number ", trackinfo.track_number, ", data offset in file ", (int)offset);
+           ", track number ", trackinfo->track_number, ", data offset in file ", (int)offset);
 
-        if (trackinfo.track_mode != CUETrack_AUDIO)
+        if (trackinfo->track_mode != CUETrack_AUDIO)
         {
-            debuglog("---- Host tried audio playback on track type ", (int)trackinfo.track_mode);
+            debuglog("---- Host tried audio playback on track type ", (int)trackinfo->track_mode);
             scsiDev.status = CHECK_CONDITION;
             scsiDev.target->sense.code = ILLEGAL_REQUEST;
             scsiDev.target->sense.asc = 0x6400; // ILLEGAL MODE FOR THIS TRACK
@@ -1331,10 +1688,25 @@ static void doPlayAudio(uint32_t lba, uint32_t length)
             return;
         }
 
+        if (!file)
+        {
+            scsiDev.status = CHECK_CONDITION;
+            scsiDev.target->sense.code = MEDIUM_ERROR;
+            scsiDev.target->sense.asc = 0x1106; // CIRC UNRECOVERED ERROR
+            scsiDev.phase = STATUS;
+            return;
+        }
+
+        // Playback past the end of this file continues in the next one
+        g_cdrom_audio_start[target_id].lba = lba;
+        g_cdrom_audio_start[target_id].offset = offset;
+        g_cdrom_audio_start[target_id].sector_length = trackinfo->sector_length;
+        g_cdrom_audio_start[target_id].file_end = getFileEndLBA(trackinfo, file->size());
+
         // playback request appears to be sane, so perform it
         // see earlier note for context on the block length below
-        if (!audio_play(target_id, &(img.file), offset,
-                offset + length * trackinfo.sector_length, false))
+        if (!audio_play(target_id, file, offset,
+                offset + (uint64_t)length * trackinfo->sector_length, false))
         {
             // Underlying data/media error? Fake a disk scratch, which should
             // be a condition most CD-DA players are expecting
@@ -1435,30 +1807,132 @@ static void doMechanismStatus(uint16_t allocation_length)
 /* CD-ROM data reading in low level format */
 /*******************************************/
 
-static void doReadCD(uint32_t lba, uint32_t length, uint8_t sector_type,
-                     uint8_t main_channel, uint8_t sub_channel, bool data_only)
+// Formatted Q subchannel data
+// Refer to table 354 in T10/1545-D MMC-4 Revision 5a
+// and ECMA-130 22.3.3
+static void formatQSubchannel(const CUETrackEntry &trackinfo, uint32_t lba, uint8_t *buf)
 {
-    image_config_t &img = *(image_config_t*)scsiDev.target->cfg;
+    *buf++ = (trackinfo.track_mode == CUETrack_AUDIO ? 0x10 : 0x14); // Control & ADR
+    *buf++ = trackinfo.track_number;
+    *buf++ = (lba >= trackinfo.data_start) ? 1 : 0; // Index number (0 = pregap)
+    int32_t rel = (int32_t)lba - (int32_t)trackinfo.data_start;
+    LBA2MSF(rel, buf, true); buf += 3;
+    *buf++ = 0;
+    LBA2MSF(lba, buf, false); buf += 3;
+    *buf++ = 0; *buf++ = 0; // CRC (optional)
+    *buf++ = 0; *buf++ = 0; *buf++ = 0; // (pad)
+    *buf++ = 0; // No P subchannel
+}
 
-#if ENABLE_AUDIO_OUTPUT
-    // terminate audio playback if active on this target (Annex C)
-    audio_stop(img.scsiId & S2S_CFG_TARGET_ID_BITS);
-#endif
+// Read sectors in large batches when no per-sector formatting is needed.
+// Each batch is read as whole SD card sectors, so that the image stays in raw
+// mode, and then the requested part of each CD sector is packed together for
+// a single transfer. Two halves of scsiDev.data are used alternately.
+// If qtrack is given, formatted Q subchannel data is appended to each sector.
+// Returns false on read error.
+static bool doReadCDBatched(ImageBackingStore *file, uint64_t offset, uint32_t stride,
+                            uint32_t skip_begin, uint32_t sector_length, uint32_t length,
+                            const CUETrackEntry *qtrack, uint32_t lba)
+{
+    const uint32_t halfbufsize = sizeof(scsiDev.data) / 2;
+    const uint32_t qlen = qtrack ? 16 : 0;
+    // Leave room for rounding the read to SD sector boundaries at both ends
+    const uint32_t batch_max = (halfbufsize - 2 * SD_SECTOR_SIZE) / (stride + qlen);
+    uint32_t sent[2] = {0, 0};
+    bool read_error = false;
 
-    CUEParser parser;
-    if (!loadCueSheet(img, parser)
-        && (sector_type == 0 || sector_type == 2)
-        && main_channel == 0x10 && sub_channel == 0)
+    uint32_t idx = 0;
+    for (int half = 0; idx < length; half ^= 1)
     {
-        // Simple case, return sector data directly
-        scsiDiskStartRead(lba, length);
-        return;
+        platform_poll();
+        diskEjectButtonUpdate(false);
+
+        // Verify that previous write using this buffer has finished
+        uint8_t *buf = scsiDev.data + half * halfbufsize;
+        uint32_t start = millis();
+        while (sent[half] > 0 && !scsiIsWriteFinished(buf + sent[half] - 1) && !scsiDev.resetFlag)
+        {
+            if ((uint32_t)(millis() - start) > 5000)
+            {
+                log("doReadCDBatched() timeout waiting for previous to finish");
+                scsiDev.resetFlag = 1;
+            }
+            platform_poll();
+            diskEjectButtonUpdate(false);
+        }
+        if (scsiDev.resetFlag) break;
+
+        // Read whole SD sectors covering the batch
+        uint32_t count = length - idx;
+        if (count > batch_max) count = batch_max;
+        uint64_t pos = offset + (uint64_t)idx * stride;
+        uint64_t aligned = pos & ~(uint64_t)(SD_SECTOR_SIZE - 1);
+        uint32_t head = pos - aligned;
+        uint32_t needed = head + count * stride;
+        uint32_t readlen = (needed + SD_SECTOR_SIZE - 1) & ~(SD_SECTOR_SIZE - 1);
+
+        // With subchannel data the output is larger than the input, so the
+        // sectors are read further into the buffer to keep packing in place.
+        uint8_t *readbuf = buf + qlen * count;
+        file->seek(aligned);
+        ssize_t got = file->read(readbuf, readlen);
+        if (got < (ssize_t)needed)
+        {
+            log("doReadCDBatched() read failed at offset ", pos, ", got ", (int)got, " bytes");
+            read_error = true;
+            break;
+        }
+
+        // Pack the requested byte range of each sector
+        uint8_t *src = readbuf + head + skip_begin;
+        uint32_t result_length = sector_length + qlen;
+        if (stride == sector_length && !qtrack)
+        {
+            if (src != buf) memmove(buf, src, count * sector_length);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < count; i++)
+            {
+                uint8_t *dst = buf + i * result_length;
+                memmove(dst, src + i * stride, sector_length);
+                if (qtrack)
+                {
+                    formatQSubchannel(*qtrack, lba + idx + i, dst + sector_length);
+                }
+            }
+        }
+
+        sent[half] = count * result_length;
+        scsiStartWrite(buf, sent[half]);
+        idx += count;
+
+        // Reset the watchdog while the transfer is progressing.
+        platform_reset_watchdog();
     }
 
+    scsiFinishWrite();
+    return !read_error;
+}
+
+// Transfer the part of a READ CD request that is stored in the same file as
+// the first sector. Returns the number of sectors transferred. On error the
+// command status is set and the phase is changed to STATUS.
+static uint32_t doReadCDPart(image_config_t &img, uint32_t lba, uint32_t length, uint8_t sector_type,
+                             uint8_t main_channel, uint8_t sub_channel, bool data_only)
+{
     // Search the track with the requested LBA
     // Supplies dummy data if no cue sheet is active.
-    CUETrackInfo trackinfo = {};
-    getTrackFromLBA(parser, lba, &trackinfo);
+    const CUETrackEntry &trackinfo = *getTrackFromLBA(img, lba);
+    ImageBackingStore *file = getTrackFile(img, &trackinfo);
+    if (!file)
+    {
+        scsiDev.status = CHECK_CONDITION;
+        scsiDev.target->sense.code = MEDIUM_ERROR;
+        scsiDev.target->sense.asc = UNRECOVERED_READ_ERROR;
+        scsiDev.phase = STATUS;
+        return 0;
+    }
 
     // Figure out the data offset in the file
     uint64_t offset = trackinfo.file_offset + trackinfo.sector_length * (lba - trackinfo.data_start);
@@ -1467,17 +1941,30 @@ static void doReadCD(uint32_t lba, uint32_t length, uint8_t sector_type,
            ", main channel ", main_channel, ", sub channel ", sub_channel,
            ", data offset in file ", (int)offset);
 
-    // Ensure read is not out of range of the image
-    uint64_t readend = offset + trackinfo.sector_length * length;
-    if (readend > img.file.size())
+    // Ensure read is not out of range of the image. With a multi-FILE
+    // cue sheet the rest of the request may continue in the next file.
+    uint64_t readend = offset + (uint64_t)trackinfo.sector_length * length;
+    if (readend > file->size())
     {
-        log("WARNING: Host attempted CD read at sector ", lba, "+", length,
-              ", exceeding image size ", img.file.size());
-        scsiDev.status = CHECK_CONDITION;
-        scsiDev.target->sense.code = ILLEGAL_REQUEST;
-        scsiDev.target->sense.asc = LOGICAL_BLOCK_ADDRESS_OUT_OF_RANGE;
-        scsiDev.phase = STATUS;
-        return;
+        uint32_t count = 0;
+        if (offset < file->size())
+        {
+            count = (file->size() - offset) / trackinfo.sector_length;
+        }
+
+        if (count == 0 || getTrackFromLBA(img, lba + count)->file_index == trackinfo.file_index)
+        {
+            log("WARNING: Host attempted CD read at sector ", lba, "+", length,
+                  ", exceeding image size ", file->size());
+            scsiDev.status = CHECK_CONDITION;
+            scsiDev.target->sense.code = ILLEGAL_REQUEST;
+            scsiDev.target->sense.asc = LOGICAL_BLOCK_ADDRESS_OUT_OF_RANGE;
+            scsiDev.phase = STATUS;
+            return 0;
+        }
+
+        debuglog("------ Read CD continues in next file at sector ", lba + count);
+        length = count;
     }
 
     // Verify sector type
@@ -1500,7 +1987,7 @@ static void doReadCD(uint32_t lba, uint32_t length, uint8_t sector_type,
             scsiDev.target->sense.code = ILLEGAL_REQUEST;
             scsiDev.target->sense.asc = 0x6400; // ILLEGAL MODE FOR THIS TRACK
             scsiDev.phase = STATUS;
-            return;
+            return 0;
         }
     }
 
@@ -1528,10 +2015,10 @@ static void doReadCD(uint32_t lba, uint32_t length, uint8_t sector_type,
     }
     else if (trackinfo.track_mode == CUETrack_MODE1_2048 && (main_channel & 0xB8) == 0xB8)
     {
-        // Transfer 2048 bytes of data from file and fake the headers
+        // Transfer 2048 bytes of data from file and generate the headers and ECC
         sector_length = 2048;
         add_fake_headers = true;
-        debuglog("------ Host requested ECC data but image file lacks it, replacing with zeros");
+        debuglog("------ Host requested ECC data but image file lacks it, generating it");
     }
     else if (trackinfo.track_mode == CUETrack_MODE1_2352 && main_channel == 0x10)
     {
@@ -1551,7 +2038,7 @@ static void doReadCD(uint32_t lba, uint32_t length, uint8_t sector_type,
         scsiDev.target->sense.code = ILLEGAL_REQUEST;
         scsiDev.target->sense.asc = 0x6400; // ILLEGAL MODE FOR THIS TRACK
         scsiDev.phase = STATUS;
-        return;
+        return 0;
     }
 
     if (data_only && sector_length != 2048)
@@ -1561,7 +2048,7 @@ static void doReadCD(uint32_t lba, uint32_t length, uint8_t sector_type,
         scsiDev.target->sense.code = ILLEGAL_REQUEST;
         scsiDev.target->sense.asc = 0x6400; // ILLEGAL MODE FOR THIS TRACK
         scsiDev.phase = STATUS;
-        return;
+        return 0;
     }
 
     bool field_q_subchannel = false;
@@ -1577,7 +2064,7 @@ static void doReadCD(uint32_t lba, uint32_t length, uint8_t sector_type,
         scsiDev.target->sense.code = ILLEGAL_REQUEST;
         scsiDev.target->sense.asc = INVALID_FIELD_IN_CDB;
         scsiDev.phase = STATUS;
-        return;
+        return 0;
     }
 
     scsiDev.phase = DATA_IN;
@@ -1585,6 +2072,22 @@ static void doReadCD(uint32_t lba, uint32_t length, uint8_t sector_type,
     scsiDev.dataPtr = 0;
     scsiEnterPhase(DATA_IN);
 
+    if (sector_length > 0 && !add_fake_headers)
+    {
+        // Sector data without generated headers, e.g. 2048 byte payload of
+        // 2352 byte BIN sectors or CD-DA extraction with Q subchannel
+        if (!doReadCDBatched(file, offset, trackinfo.sector_length, skip_begin, sector_length, length,
+                             field_q_subchannel ? &trackinfo : NULL, lba))
+        {
+            scsiDev.status = CHECK_CONDITION;
+            scsiDev.target->sense.code = MEDIUM_ERROR;
+            scsiDev.target->sense.asc = UNRECOVERED_READ_ERROR;
+            scsiDev.phase = STATUS;
+            return 0;
+        }
+        return length;
+    }
+
     // Use two buffers alternately for formatting sector data
     uint32_t result_length = sector_length + (field_q_subchannel ? 16 : 0) + (add_fake_headers ? 304 : 0);
     uint8_t *buf0 = scsiDev.data;
@@ -1596,7 +2099,7 @@ static void doReadCD(uint32_t lba, uint32_t length, uint8_t sector_type,
         platform_poll();
         diskEjectButtonUpdate(false);
 
-        img.file.seek(offset + idx * trackinfo.sector_length + skip_begin);
+        file->seek(offset + idx * trackinfo.sector_length + skip_begin);
 
         // Verify that previous write using this buffer has finished
         uint8_t *buf = ((idx & 1) ? buf1 : buf0);
@@ -1633,32 +2136,22 @@ static void doReadCD(uint32_t lba, uint32_t length, uint8_t sector_type,
         if (sector_length > 0)
         {
             // User data
-            img.file.read(buf, sector_length);
+            file->read(buf, sector_length);
             buf += sector_length;
         }
 
         if (add_fake_headers)
         {
-            // 288 bytes of ECC
-            memset(buf, 0, 288);
+            // 288 bytes of EDC and ECC, computed while previous sector
+            // is still being transferred from the other buffer.
+            cd_mode1_generate_ecc(bufstart);
             buf += 288;
         }
 
         if (field_q_subchannel)
         {
-            // Formatted Q subchannel data
-            // Refer to table 354 in T10/1545-D MMC-4 Revision 5a
-            // and ECMA-130 22.3.3
-            *buf++ = (trackinfo.track_mode == CUETrack_AUDIO ? 0x10 : 0x14); // Control & ADR
-            *buf++ = trackinfo.track_number;
-            *buf++ = (lba + idx >= trackinfo.data_start) ? 1 : 0; // Index number (0 = pregap)
-            int32_t rel = (int32_t)(lba + idx) - (int32_t)trackinfo.data_start;
-            LBA2MSF(rel, buf, true); buf += 3;
-            *buf++ = 0;
-            LBA2MSF(lba + idx, buf, false); buf += 3;
-            *buf++ = 0; *buf++ = 0; // CRC (optional)
-            *buf++ = 0; *buf++ = 0; *buf++ = 0; // (pad)
-            *buf++ = 0; // No P subchannel
+            formatQSubchannel(trackinfo, lba + idx, buf);
+            buf += 16;
         }
 
         assert(buf == bufstart + result_length);
@@ -1672,6 +2165,40 @@ static void doReadCD(uint32_t lba, uint32_t length, uint8_t sector_type,
     }
 
     scsiFinishWrite();
+    return length;
+}
+
+static void doReadCD(uint32_t lba, uint32_t length, uint8_t sector_type,
+                     uint8_t main_channel, uint8_t sub_channel, bool data_only)
+{
+    image_config_t &img = *(image_config_t*)scsiDev.target->cfg;
+
+#if ENABLE_AUDIO_OUTPUT
+    // terminate audio playback if active on this target (Annex C)
+    audio_stop(img.scsiId & S2S_CFG_TARGET_ID_BITS);
+#endif
+
+    if (img.cuetrackcount == 0
+        && (sector_type == 0 || sector_type == 2)
+        && main_channel == 0x10 && sub_channel == 0)
+    {
+        // Simple case, return sector data directly
+        scsiDiskStartRead(lba, length);
+        return;
+    }
+
+    // Tracks of a multi-FILE cue sheet are read one file at a time
+    do
+    {
+        uint32_t count = doReadCDPart(img, lba, length, sector_type, main_channel, sub_channel, data_only);
+        if (scsiDev.phase == STATUS)
+        {
+            return;
+        }
+
+        lba += count;
+        length -= count;
+    } while (length > 0 && !scsiDev.resetFlag);
 
     scsiDev.status = 0;
     scsiDev.phase = STATUS;
@@ -1690,10 +2217,7 @@ static void doReadSubchannel(bool time, bool subq, uint8_t parameter, uint8_t tr
 
         // Fetch current track info
         image_config_t &img = *(image_config_t*)scsiDev.target->cfg;
-        CUEParser parser;
-        CUETrackInfo trackinfo = {};
-        loadCueSheet(img, parser);
-        getTrackFromLBA(parser, lba, &trackinfo);
+        const CUETrackEntry &trackinfo = *getTrackFromLBA(img, lba);
 
         // Request sub channel data at current playback position
         *buf++ = 0; // Reserved
@@ -1769,38 +2293,21 @@ static bool doReadCapacity(uint32_t lba, uint8_t pmi)
 {
     image_config_t &img = *(image_config_t*)scsiDev.target->cfg;
 
-    CUEParser parser;
-    if (!loadCueSheet(img, parser))
+    if (img.cuetrackcount == 0)
     {
         // basic image, let the disk handler resolve
         return false;
     }
 
-    // find the last track on the disk
-    CUETrackInfo lasttrack = {0};
-    const CUETrackInfo *trackinfo;
-    while ((trackinfo = parser.next_track()) != NULL)
-    {
-        lasttrack = *trackinfo;
-    }
-
-    uint32_t capacity = 0;
-    if (lasttrack.track_number != 0)
-    {
-        capacity = getLeadOutLBA(&lasttrack);
-        capacity--; // shift to last addressable LBA
-        if (pmi && lba && lba > capacity)
-        {
-            // MMC technically specifies that PMI should be zero, but SCSI-2 allows this
-            // potentially consider treating either out-of-bounds or PMI set as an error
-            // for now just ignore this
-        }
-        debuglog("----- Reporting capacity as ", capacity);
-    }
-    else
+    uint32_t capacity = getLeadOutLBA(img);
+    capacity--; // shift to last addressable LBA
+    if (pmi && lba && lba > capacity)
     {
-        log("WARNING: unable to find capacity, no cue file found for ID ", img.scsiId);
+        // MMC technically specifies that PMI should be zero, but SCSI-2 allows this
+        // potentially consider treating either out-of-bounds or PMI set as an error
+        // for now just ignore this
     }
+    debuglog("----- Reporting capacity as ", capacity);
 
     scsiDev.data[0] = capacity >> 24;
     scsiDev.data[1] = capacity >> 16;
@@ -1826,7 +2333,11 @@ extern "C" int scsiCDRomCommand()
     int commandHandled = 1;
 
     uint8_t command = scsiDev.cdb[0];
-    if (command == 0x1B)
+    if (cdromFastPoll(img, command))
+    {
+        // Answered from cached media state
+    }
+    else if (command == 0x1B)
     {
 #if ENABLE_AUDIO_OUTPUT
         // terminate audio playback if active on this target (MMC-1 Annex C)
@@ -2011,8 +2522,7 @@ extern "C" int scsiCDRomCommand()
                 && scsiDev.cdb[5] == 0xFF)
         {
             // request to start playback from 'current position'
-            image_config_t &img = *(image_config_t*)scsiDev.target->cfg;
-            lba = img.file.position() / 2352;
+            cdromGetAudioPlaybackStatus(NULL, &lba, true);
         }
 
         uint32_t length = end - lba;
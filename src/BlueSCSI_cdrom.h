@@ -22,8 +22,15 @@ void cdromPerformEject(image_config_t &img);
 void cdromReinsertFirstImage(image_config_t &img);
 
 // Check if the currently loaded cue sheet for the image can be parsed
-// and print warnings about unsupported track types
-bool cdromValidateCueSheet(image_config_t &img);
+// and print warnings about unsupported track types.
+// If firstfile is given, the first FILE of the cue sheet must have that name.
+bool cdromValidateCueSheet(image_config_t &img, const char *cuesheetname, const char *firstfile = NULL);
+
+// Close per-track data files opened for multi-FILE cue sheet
+void cdromCloseTrackFiles(image_config_t &img);
+
+// Return the cue sheet track table of the image to the shared pool
+void cdromReleaseCueTable(image_config_t &img);
 
 // Audio playback status
 // boolean flag is true if just basic mechanism status (playback true/false)
@@ -15,6 +15,7 @@
 #define CONFIGFILE_BAD  "bluescsi.ini.txt"
 #define LOGFILE     "log.txt"
 #define CRASHFILE   "err.txt"
+#define TIMELINEFILE "timeline.bin"
 
 // Log buffer size in bytes, must be a power of 2
 #ifndef LOGBUFSIZE
@@ -22,6 +23,22 @@
 #endif
 #define LOG_SAVE_INTERVAL_MS 1000
 
+// Size of preallocated circular log file and maximum number of sectors
+// written to it per save when the bus is idle.
+#define LOG_FILE_SIZE (256 * 1024)
+#define LOG_SAVE_MAX_SECTORS 4
+
+// Deferred binary log size in 32-bit words, must be a power of 2
+#ifndef LOG_BINARY_WORDS
+#define LOG_BINARY_WORDS 1024
+#endif
+
+// Set to 1 to keep formatting log messages immediately after boot,
+// so that UART output is never delayed (debug builds).
+#ifndef LOG_IMMEDIATE
+#define LOG_IMMEDIATE 0
+#endif
+
 // Watchdog timeout
 // Watchdog will first issue a bus reset and if that does not help, crashdump.
 #define WATCHDOG_BUS_RESET_TIMEOUT 15000
@@ -78,6 +95,37 @@
 #define DEFAULT_SCSI_DELAY_US 10
 #define DEFAULT_REQ_TYPE_SETUP_NS 500
 
+// Default access time model for floppy and SCSI-1 targets.
+// Can be adjusted per target in ini file, the full stroke time
+// matches the fixed 10 ms delay used by earlier firmware.
+#define DEFAULT_SEEK_TRACK_US 3000
+#define DEFAULT_SEEK_FULL_US 10000
+#define DEFAULT_ROTATION_US 0
+// Upper limit for each of the above settings, keeps the total delay
+// within the range of s2s_delay_us()
+#define MAX_ACCESS_TIME_US 1000000
+
+// Geometry used by the access time model for floppies that have no
+// geometry of their own configured
+#define FLOPPY_SECTORS_PER_TRACK 18
+#define FLOPPY_HEADS_PER_CYLINDER 2
+
+// Maximum number of tracks kept from a CD-ROM cue sheet
+#ifndef CDROM_MAX_TRACKS
+#define CDROM_MAX_TRACKS 99
+#endif
+
+// Number of cue sheet track tables, i.e. how many CD-ROM targets
+// can have a cue sheet loaded at the same time
+#ifndef CDROM_CUE_TABLES
+#define CDROM_CUE_TABLES NUM_SCSIID
+#endif
+
+// Number of open per-track files for multi-FILE cue sheets, shared by all targets
+#ifndef CDROM_FILE_CACHE_SIZE
+#define CDROM_FILE_CACHE_SIZE 4
+#endif
+
 // Use prefetch buffer in read requests
 #ifndef PREFETCH_BUFFER_SIZE
 #define PREFETCH_BUFFER_SIZE 8192
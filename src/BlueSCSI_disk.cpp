@@ -10,6 +10,7 @@
 #include "BlueSCSI_disk.h"
 #include "BlueSCSI_log.h"
 #include "BlueSCSI_config.h"
+#include "BlueSCSI_stats.h"
 #include "BlueSCSI_presets.h"
 #ifdef ENABLE_AUDIO_OUTPUT
 #include "BlueSCSI_audio.h"
@@ -31,6 +32,7 @@ extern "C" {
 #include <scsi2sd_time.h>
 #include <sd.h>
 #include <mode.h>
+#include <geometry.h>
 }
 
 #ifndef PLATFORM_MAX_SCSI_SPEED
@@ -167,6 +169,7 @@ void scsiDiskResetImages()
 void image_config_t::clear()
 {
     static const image_config_t empty; // Statically zero-initialized
+    cdromReleaseCueTable(*this);
     *this = empty;
 }
 
@@ -180,6 +183,9 @@ void scsiDiskCloseSDCardImages()
         }
 
         g_DiskImages[i].cuesheetfile.close();
+        cdromReleaseCueTable(g_DiskImages[i]);
+        g_DiskImages[i].poll_ready = false;
+        cdromCloseTrackFiles(g_DiskImages[i]);
     }
 }
 
@@ -372,6 +378,8 @@ bool scsiDiskOpenHDDImage(const char *filename, int scsi_id, int scsi_lun, int b
 {
     image_config_t &img = g_DiskImages[scsi_id];
     img.cuesheetfile.close();
+    cdromReleaseCueTable(img);
+    img.poll_ready = false;
     img.file = ImageBackingStore(filename, block_size);
 
     if (img.file.isOpen())
@@ -482,13 +490,27 @@ bool scsiDiskOpenHDDImage(const char *filename, int scsi_id, int scsi_lun, int b
             strlcat(cuesheetname, ".cue", sizeof(cuesheetname));
             img.cuesheetfile = SD.open(cuesheetname, O_RDONLY);
 
+            // The shared cue sheet is only valid for the file of its first
+            // track, other track files are used as plain binary images.
+            const char *firstfile = NULL;
+            char *tracksuffix = strstr(cuesheetname, " (Track ");
+            if (!img.cuesheetfile.isOpen() && tracksuffix)
+            {
+                // Redump style "Name (Track 1).bin" with "Name.cue"
+                strcpy(tracksuffix, ".cue");
+                img.cuesheetfile = SD.open(cuesheetname, O_RDONLY);
+                firstfile = strrchr(filename, '/');
+                firstfile = firstfile ? firstfile + 1 : filename;
+            }
+
             if (img.cuesheetfile.isOpen())
             {
                 log("---- Found CD-ROM CUE sheet at ", cuesheetname);
-                if (!cdromValidateCueSheet(img))
+                if (!cdromValidateCueSheet(img, cuesheetname, firstfile))
                 {
                     log("---- Failed to parse cue sheet, using as plain binary image");
                     img.cuesheetfile.close();
+                    cdromReleaseCueTable(img);
                 }
             }
             else
@@ -582,6 +604,9 @@ static void scsiDiskConfigDefaults(int target_idx)
     img.bytesPerSector = defaults.bytesPerSector;
     img.quirks = defaults.quirks;
     img.prefetchbytes = defaults.prefetchBytes;
+    img.seek_track_us = DEFAULT_SEEK_TRACK_US;
+    img.seek_full_us = DEFAULT_SEEK_FULL_US;
+    img.rotation_us = DEFAULT_ROTATION_US;
     img.reinsert_on_inquiry = false;
     img.reinsert_after_eject = true;
     memset(img.vendor, 0, sizeof(img.vendor));
@@ -590,6 +615,19 @@ static void scsiDiskConfigDefaults(int target_idx)
     memset(img.serial, 0, sizeof(img.serial));
 }
 
+// Read an integer setting limited to the range 0 to max
+static uint32_t ini_getl_clamped(const char *section, const char *key, uint32_t defaultval, uint32_t max)
+{
+    long value = ini_getl(section, key, defaultval, CONFIGFILE);
+    if (value < 0) return 0;
+    if ((unsigned long)value > max)
+    {
+        log("---- ", key, " limited to ", (int)max);
+        return max;
+    }
+    return value;
+}
+
 // Load values for target configuration from given section if they exist.
 // Otherwise, keep current settings.
 static void scsiDiskLoadConfig(int target_idx, const char *section)
@@ -604,6 +642,9 @@ static void scsiDiskLoadConfig(int target_idx, const char *section)
     img.rightAlignStrings = ini_getbool(section, "RightAlignStrings", 0, CONFIGFILE);
     img.name_from_image = ini_getbool(section, "NameFromImage", 0, CONFIGFILE);
     img.prefetchbytes = ini_getl(section, "PrefetchBytes", img.prefetchbytes, CONFIGFILE);
+    img.seek_track_us = ini_getl_clamped(section, "SeekTrackToTrackUs", img.seek_track_us, MAX_ACCESS_TIME_US);
+    img.seek_full_us = ini_getl_clamped(section, "SeekFullStrokeUs", img.seek_full_us, MAX_ACCESS_TIME_US);
+    img.rotation_us = ini_getl_clamped(section, "RotationUs", img.rotation_us, MAX_ACCESS_TIME_US);
     img.reinsert_on_inquiry = ini_getbool(section, "ReinsertCDOnInquiry", img.reinsert_on_inquiry, CONFIGFILE);
     img.reinsert_after_eject = ini_getbool(section, "ReinsertAfterEject", img.reinsert_after_eject, CONFIGFILE);
     img.ejectButton = ini_getl(section, "EjectButton", 0, CONFIGFILE);
@@ -1419,6 +1460,57 @@ static bool doTestUnitReady()
 /* Seek command */
 /****************/
 
+// Emulate the access time of slow devices. An access that continues where
+// the previous one ended gets no delay. Otherwise the head always takes at
+// least the track-to-track time, plus a seek time linear in cylinder
+// distance, followed by the rotational delay until the requested sector
+// comes around.
+static void diskAccessDelay(image_config_t &img, uint32_t lba, uint32_t blocks, uint32_t capacity)
+{
+    uint32_t head_lba = img.head_lba;
+    img.head_lba = lba + blocks;
+    if (lba == head_lba) return;
+
+    uint16_t sectorsPerTrack = img.sectorsPerTrack ? img.sectorsPerTrack : 1;
+    uint16_t headsPerCylinder = img.headsPerCylinder ? img.headsPerCylinder : 1;
+    if (img.deviceType == S2S_CFG_FLOPPY_14MB &&
+        (uint32_t)sectorsPerTrack * headsPerCylinder >= capacity)
+    {
+        // Hard disk default geometry would put the whole floppy on one
+        // cylinder, model the head movement of a 1.44 MB drive instead
+        sectorsPerTrack = FLOPPY_SECTORS_PER_TRACK;
+        headsPerCylinder = FLOPPY_HEADS_PER_CYLINDER;
+    }
+
+    uint32_t cyl_from, cyl_to, sec_from, sec_to;
+    uint8_t head;
+    LBA2CHS(head_lba, &cyl_from, &head, &sec_from, headsPerCylinder, sectorsPerTrack);
+    LBA2CHS(lba, &cyl_to, &head, &sec_to, headsPerCylinder, sectorsPerTrack);
+
+    uint32_t delay_us = img.seek_track_us;
+    if (cyl_from != cyl_to)
+    {
+        uint32_t distance = (cyl_to > cyl_from) ? (cyl_to - cyl_from) : (cyl_from - cyl_to);
+        uint32_t cylinders = capacity / ((uint32_t)sectorsPerTrack * headsPerCylinder);
+        if (cylinders > 1 && distance > 1 && img.seek_full_us > img.seek_track_us)
+        {
+            if (distance > cylinders - 1) distance = cylinders - 1;
+            delay_us += (uint64_t)(img.seek_full_us - img.seek_track_us) * (distance - 1) / (cylinders - 1);
+        }
+    }
+
+    if (img.rotation_us > 0)
+    {
+        uint32_t sectors = (sec_to + sectorsPerTrack - sec_from) % sectorsPerTrack;
+        delay_us += (uint64_t)img.rotation_us * sectors / sectorsPerTrack;
+    }
+
+    if (delay_us > 0)
+    {
+        s2s_delay_us(delay_us);
+    }
+}
+
 static void doSeek(uint32_t lba)
 {
     image_config_t &img = *(image_config_t*)scsiDev.target->cfg;
@@ -1437,7 +1529,7 @@ static void doSeek(uint32_t lba)
         if (unlikely(scsiDev.target->cfg->deviceType == S2S_CFG_FLOPPY_14MB) ||
             scsiDev.compatMode < COMPAT_SCSI2)
         {
-            s2s_delay_ms(10);
+            diskAccessDelay(img, lba, 0, capacity);
         }
         else
         {
@@ -1477,16 +1569,16 @@ static struct {
 
 void scsiDiskStartWrite(uint32_t lba, uint32_t blocks)
 {
+    image_config_t &img = *(image_config_t*)scsiDev.target->cfg;
+    uint32_t bytesPerSector = scsiDev.target->liveCfg.bytesPerSector;
+    uint32_t capacity = img.file.size() / bytesPerSector;
+
     if (unlikely(scsiDev.target->cfg->deviceType == S2S_CFG_FLOPPY_14MB)) {
         // Floppies are supposed to be slow. Some systems can't handle a floppy
         // without an access time
-        s2s_delay_ms(10);
+        diskAccessDelay(img, lba, blocks, capacity);
     }
 
-    image_config_t &img = *(image_config_t*)scsiDev.target->cfg;
-    uint32_t bytesPerSector = scsiDev.target->liveCfg.bytesPerSector;
-    uint32_t capacity = img.file.size() / bytesPerSector;
-
     debuglog("------ Write ", (int)blocks, "x", (int)bytesPerSector, " starting at ", (int)lba);
 
     if (unlikely(blockDev.state & DISK_WP) ||
@@ -1725,16 +1817,16 @@ void diskDataOut()
 
 void scsiDiskStartRead(uint32_t lba, uint32_t blocks)
 {
+    image_config_t &img = *(image_config_t*)scsiDev.target->cfg;
+    uint32_t bytesPerSector = scsiDev.target->liveCfg.bytesPerSector;
+    uint32_t capacity = img.file.size() / bytesPerSector;
+
     if (unlikely(scsiDev.target->cfg->deviceType == S2S_CFG_FLOPPY_14MB)) {
         // Floppies are supposed to be slow. Some systems can't handle a floppy
         // without an access time
-        s2s_delay_ms(10);
+        diskAccessDelay(img, lba, blocks, capacity);
     }
 
-    image_config_t &img = *(image_config_t*)scsiDev.target->cfg;
-    uint32_t bytesPerSector = scsiDev.target->liveCfg.bytesPerSector;
-    uint32_t capacity = img.file.size() / bytesPerSector;
-
     debuglog("------ Read ", (int)blocks, "x", (int)bytesPerSector, " starting at ", (int)lba);
 
     if (unlikely(((uint64_t) lba) + blocks > capacity))
@@ -1771,6 +1863,7 @@ void scsiDiskStartRead(uint32_t lba, uint32_t blocks)
             if (count > transfer.blocks) count = transfer.blocks;
             scsiStartWrite(g_scsi_prefetch.buffer + start_offset * bytesPerSector, count * bytesPerSector);
             debuglog("------ Found ", (int)count, " sectors in prefetch cache");
+            scsiStatsCacheHit();
             transfer.currentBlock += count;
         }
 
@@ -2035,7 +2128,11 @@ int scsiDiskCommand()
     else if (unlikely(command == 0x00))
     {
         // TEST UNIT READY
-        doTestUnitReady();
+        if (doTestUnitReady() && img.deviceType == S2S_CFG_OPTICAL)
+        {
+            // Answer further polls from scsiCDRomCommand() until media changes
+            img.poll_ready = true;
+        }
     }
     else if (unlikely(!doTestUnitReady()))
     {
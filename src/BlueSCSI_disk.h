@@ -34,6 +34,7 @@
 #include <scsiPhy.h>
 #include "ImageBackingStore.h"
 #include "BlueSCSI_config.h"
+#include <CUEParser.h>
 
 extern "C" {
 #include <disk.h>
@@ -51,6 +52,7 @@ struct image_config_t: public S2S_TargetCfg
     // For CD-ROM drive ejection
     bool ejected;
     uint8_t cdrom_events;
+    bool poll_ready; // Cached TEST UNIT READY result for optical drives, cleared on media change
     bool reinsert_on_inquiry; // Reinsert on Inquiry command (to reinsert automatically after boot)
     bool reinsert_after_eject; // Reinsert next image after ejection
 
@@ -74,6 +76,15 @@ struct image_config_t: public S2S_TargetCfg
     // Cue sheet file for CD-ROM images
     FsFile cuesheetfile;
 
+    // Tracks parsed from the cue sheet when the image was loaded, the table
+    // is taken from a shared pool by cdromValidateCueSheet().
+    // cuetrackcount is 0 if there is no valid cue sheet.
+    CUETrackEntry *cuetracks;
+    uint8_t cuetrackcount;
+    uint32_t cueleadout; // LBA of lead-out, after end of last track
+    uint8_t cuelasttrack; // Index of track found by previous LBA lookup
+    char cuedir[MAX_FILE_PATH]; // Directory of cue sheet, for opening per-track files
+
     // Right-align vendor / product type strings (for Apple)
     // Standard SCSI uses left alignment
     // This field uses -1 for default when field is not set in .ini
@@ -88,6 +99,12 @@ struct image_config_t: public S2S_TargetCfg
     // Warning about geometry settings
     bool geometrywarningprinted;
 
+    // Access time model for floppy and SCSI-1 targets, in microseconds
+    uint32_t seek_track_us; // Seek to adjacent cylinder
+    uint32_t seek_full_us; // Seek across all cylinders
+    uint32_t rotation_us; // One revolution, 0 disables rotational latency
+    uint32_t head_lba; // LBA following the previous access
+
     // Clear any image state to zeros
     void clear();
 
@@ -73,11 +73,29 @@ static struct {
     uint32_t failposition;
     bool ejectWhenDone;
 
+    // Synchronous transfer negotiation.
+    // Values are in SDTR message units, period is multiple of 4 ns.
+    uint8_t sync_period_request; // 0 if only asynchronous transfers are allowed
+    uint8_t sync_offset_request;
+    uint8_t sync_negotiated; // Bitmap of targets that have completed negotiation
+    bool sync_negotiating; // SDTR message sent in current command
+    uint8_t sync_period[8];
+    uint8_t sync_offset[8];
+
     FsFile target_file;
 } g_initiator_state;
 
 extern SdFs SD;
 
+// All targets return to asynchronous mode after bus reset
+static void scsiInitiatorResetSync()
+{
+    g_initiator_state.sync_negotiated = 0;
+    g_initiator_state.sync_negotiating = false;
+    memset(g_initiator_state.sync_period, 0, sizeof(g_initiator_state.sync_period));
+    memset(g_initiator_state.sync_offset, 0, sizeof(g_initiator_state.sync_offset));
+}
+
 // Initialization of initiator mode
 void scsiInitiatorInit()
 {
@@ -94,6 +112,22 @@ void scsiInitiatorInit()
     }
     g_initiator_state.maxRetryCount = ini_getl("SCSI", "InitiatorMaxRetry", 5, CONFIGFILE);
 
+    int maxSyncSpeed = ini_getl("SCSI", "InitiatorMaxSyncSpeed", 10, CONFIGFILE);
+    if (maxSyncSpeed >= 10)
+        g_initiator_state.sync_period_request = 25; // 100 ns, 10 MB/s
+    else if (maxSyncSpeed >= 5)
+        g_initiator_state.sync_period_request = 50; // 200 ns, 5 MB/s
+    else
+        g_initiator_state.sync_period_request = 0;
+    g_initiator_state.sync_offset_request = 15;
+
+    if (g_initiator_state.sync_period_request > 0 && !scsiHostPhyHasATN())
+    {
+        debuglog("No ATN output on this hardware, initiator uses asynchronous transfers");
+        g_initiator_state.sync_period_request = 0;
+    }
+    scsiInitiatorResetSync();
+
     // treat initiator id as already imaged drive so it gets skipped
     g_initiator_state.drives_imaged = 1 << g_initiator_state.initiator_id;
     g_initiator_state.imaging = false;
@@ -151,6 +185,7 @@ void scsiInitiatorMainLoop()
     {
         log("Executing BUS RESET after aborted command");
         scsiHostPhyReset();
+        scsiInitiatorResetSync();
     }
 
     if (!g_initiator_state.imaging)
@@ -384,19 +419,128 @@ void scsiInitiatorMainLoop()
  * Low level command implementations *
  *************************************/
 
+// Send IDENTIFY message, followed by SDTR if negotiation was requested by asserting ATN.
+static void scsiInitiatorMessageOut()
+{
+    if (g_initiator_state.sync_negotiating)
+    {
+        uint8_t msg[6] = {0x80, 0x01, 0x03, 0x01,
+                          g_initiator_state.sync_period_request,
+                          g_initiator_state.sync_offset_request};
+        uint32_t sent = scsiHostWrite(msg, sizeof(msg) - 1);
+
+        // ATN must be released before the last byte is acknowledged
+        scsiHostPhySetATN(false);
+        if (sent == sizeof(msg) - 1)
+        {
+            scsiHostWrite(&msg[sizeof(msg) - 1], 1);
+        }
+    }
+    else
+    {
+        uint8_t identify_msg = 0x80;
+        scsiHostPhySetATN(false);
+        scsiHostWrite(&identify_msg, 1);
+    }
+}
+
+// Apply the transfer mode agreed with target and remember it for following commands
+static void scsiInitiatorSetSync(int target_id, int period, int offset)
+{
+    g_initiator_state.sync_negotiating = false;
+    g_initiator_state.sync_negotiated |= (1 << target_id);
+    g_initiator_state.sync_period[target_id] = period;
+    g_initiator_state.sync_offset[target_id] = offset;
+    scsiHostPhySetSyncMode(offset, period);
+
+    if (offset > 0)
+    {
+        log("SCSI ID ", target_id, " using synchronous transfers, period ", period * 4, " ns, offset ", offset);
+    }
+    else
+    {
+        log("SCSI ID ", target_id, " using asynchronous transfers");
+    }
+}
+
+// Read message from target and handle the response to our SDTR
+static void scsiInitiatorMessageIn(int target_id)
+{
+    uint8_t msg = 0;
+    scsiHostRead(&msg, 1);
+
+    if (msg == 0x01)
+    {
+        // Extended message, up to 255 bytes
+        uint8_t len = 0;
+        uint8_t extmsg[3] = {0};
+        scsiHostRead(&len, 1);
+        for (int i = 0; i < len; i++)
+        {
+            uint8_t tmp = 0;
+            scsiHostRead(&tmp, 1);
+            if (i < (int)sizeof(extmsg)) extmsg[i] = tmp;
+        }
+
+        if (extmsg[0] == 0x01 && len == 3)
+        {
+            if (!g_initiator_state.sync_negotiating)
+            {
+                // Responding to target initiated negotiation needs ATN.
+                // Without a response both sides fall back to asynchronous mode.
+                debuglog("------ Target ", target_id, " initiated SDTR, staying asynchronous");
+                scsiInitiatorSetSync(target_id, 0, 0);
+                return;
+            }
+
+            // Target may only slow down the transfers from what we requested
+            int period = extmsg[1];
+            int offset = extmsg[2];
+            if (period < g_initiator_state.sync_period_request) period = g_initiator_state.sync_period_request;
+            if (offset > g_initiator_state.sync_offset_request) offset = g_initiator_state.sync_offset_request;
+            if (period == 0 || offset == 0)
+            {
+                period = offset = 0;
+            }
+
+            scsiInitiatorSetSync(target_id, period, offset);
+        }
+        else
+        {
+            debuglog("------ Ignoring extended message ", bytearray(extmsg, sizeof(extmsg)));
+        }
+    }
+    else if (msg == 0x07 && g_initiator_state.sync_negotiating)
+    {
+        // MESSAGE REJECT, target does not support synchronous transfers
+        scsiInitiatorSetSync(target_id, 0, 0);
+    }
+}
+
 int scsiInitiatorRunCommand(int target_id,
                             const uint8_t *command, size_t cmdLen,
                             uint8_t *bufIn, size_t bufInLen,
                             const uint8_t *bufOut, size_t bufOutLen,
                             bool returnDataPhase)
 {
+    // Negotiate synchronous transfers on first command after reset.
+    // ATN asserted during selection makes the target enter MESSAGE_OUT phase.
+    g_initiator_state.sync_negotiating =
+        g_initiator_state.sync_period_request > 0 &&
+        !(g_initiator_state.sync_negotiated & (1 << target_id));
+    scsiHostPhySetATN(g_initiator_state.sync_negotiating);
+
     if (!scsiHostPhySelect(target_id, g_initiator_state.initiator_id))
     {
         debuglog("------ Target ", target_id, " did not respond");
+        g_initiator_state.sync_negotiating = false;
         scsiHostPhyRelease();
         return -1;
     }
 
+    scsiHostPhySetSyncMode(g_initiator_state.sync_offset[target_id],
+                           g_initiator_state.sync_period[target_id]);
+
     SCSI_PHASE phase;
     int status = -1;
     while ((phase = (SCSI_PHASE)scsiHostPhyGetPhase()) != BUS_FREE)
@@ -405,16 +549,20 @@ int scsiInitiatorRunCommand(int target_id,
 
         if (phase == MESSAGE_IN)
         {
-            uint8_t dummy = 0;
-            scsiHostRead(&dummy, 1);
+            scsiInitiatorMessageIn(target_id);
         }
         else if (phase == MESSAGE_OUT)
         {
-            uint8_t identify_msg = 0x80;
-            scsiHostWrite(&identify_msg, 1);
+            scsiInitiatorMessageOut();
         }
         else if (phase == COMMAND)
         {
+            if (g_initiator_state.sync_negotiating)
+            {
+                // Target did not respond to SDTR, it will use asynchronous transfers
+                scsiInitiatorSetSync(target_id, 0, 0);
+            }
+
             scsiHostWrite(command, cmdLen);
         }
         else if (phase == DATA_IN)
@@ -815,13 +963,11 @@ bool scsiInitiatorReadDataToFile(int target_id, uint32_t start_sector, uint32_t
 
         if (phase == MESSAGE_IN)
         {
-            uint8_t dummy = 0;
-            scsiHostRead(&dummy, 1);
+            scsiInitiatorMessageIn(target_id);
         }
         else if (phase == MESSAGE_OUT)
         {
-            uint8_t identify_msg = 0x80;
-            scsiHostWrite(&identify_msg, 1);
+            scsiInitiatorMessageOut();
         }
         else if (phase == STATUS)
         {
@@ -4,11 +4,13 @@
 #include "BlueSCSI_log.h"
 #include "BlueSCSI_config.h"
 #include "BlueSCSI_platform.h"
+#include <string.h>
 
 const char *g_log_firmwareversion = BLUESCSI_FW_VERSION " " __DATE__ " " __TIME__;
 bool g_log_debug = false;
 uint8_t g_scsi_log_mask = 0;
 bool g_test_mode = false;
+bool g_log_immediate = true;
 
 // This memory buffer can be read by debugger and is also saved to log.txt
 #define LOGBUFMASK (LOGBUFSIZE - 1)
@@ -19,7 +21,37 @@ uint32_t g_log_magic;
 char g_logbuffer[LOGBUFSIZE + 1];
 uint32_t g_logpos;
 
-void log_raw(const char *str)
+// Binary log records waiting to be formatted, see BlueSCSI_log.h.
+// Each record is:
+//   header:    LOG_RECORD_MAGIC | flags << 20 | nargs << 12 | total words
+//   timestamp: millis() when the record was written
+//   tags:      4-bit type tag per argument, 8 per word
+//   arguments: raw values, strings and byte arrays copied inline
+#define LOGBINMASK (LOG_BINARY_WORDS - 1)
+#define LOG_RECORD_MAGIC 0xB1000000
+#define LOG_RECORD_MAX_WORDS (LOG_BINARY_WORDS / 4)
+#define LOG_BYTEARRAY_MAX 34
+
+enum log_arg_tag_t {
+    LOG_ARG_ROMSTR = 1, // Pointer to string in flash
+    LOG_ARG_STR,        // Length word + characters
+    LOG_ARG_U8,
+    LOG_ARG_U32,
+    LOG_ARG_U64,
+    LOG_ARG_INT,
+    LOG_ARG_DOUBLE,
+    LOG_ARG_BOOL,
+    LOG_ARG_BYTES,      // Total length word + up to LOG_BYTEARRAY_MAX bytes
+};
+
+static struct {
+    uint32_t words[LOG_BINARY_WORDS];
+    uint32_t wrpos;
+    uint32_t rdpos;
+    bool formatting;
+} g_logbinary;
+
+static void log_text(const char *str)
 {
     // Keep log from reboot / bootloader if magic matches expected value
     if (g_log_magic != 0xAA55AA55)
@@ -41,6 +73,13 @@ void log_raw(const char *str)
     platform_log(str);
 }
 
+void log_raw(const char *str)
+{
+    // Keep message order when mixing direct and deferred logging
+    log_format_pending();
+    log_text(str);
+}
+
 // Log byte as hex
 void log_raw(uint8_t value)
 {
@@ -107,20 +146,25 @@ void log_raw(int value)
     log_raw(p);
 }
 
-void log_raw(bytearray array)
+static void log_bytes(const uint8_t *data, size_t count, size_t total)
 {
-    for (size_t i = 0; i < array.len; i++)
+    for (size_t i = 0; i < count; i++)
     {
-        log_raw(array.data[i]);
+        log_raw(data[i]);
         log_raw(" ");
         if (i > 32)
         {
-            log_raw("... (total ", (int)array.len, ")");
+            log_raw("... (total ", (int)total, ")");
             break;
         }
     }
 }
 
+void log_raw(bytearray array)
+{
+    log_bytes(array.data, array.len, array.len);
+}
+
 void log_raw(double value)
 {
     char buffer[6];
@@ -166,13 +210,318 @@ void log_buf(const unsigned char *buf, unsigned long size)
     log_f("%s", tmp);
 }
 
+/*************************/
+/* Deferred binary log   */
+/*************************/
+
+static inline void log_put_word(log_record_t &rec, uint32_t value)
+{
+    g_logbinary.words[rec.pos++ & LOGBINMASK] = value;
+}
+
+static inline void log_put_tag(log_record_t &rec, uint32_t tag)
+{
+    g_logbinary.words[(rec.tagpos + rec.argidx / 8) & LOGBINMASK] |= tag << (4 * (rec.argidx % 8));
+    rec.argidx++;
+}
+
+static void log_put_bytes(log_record_t &rec, const uint8_t *data, uint32_t len)
+{
+    while (len > 0)
+    {
+        uint32_t word = 0;
+        uint32_t n = (len > 4) ? 4 : len;
+        memcpy(&word, data, n);
+        log_put_word(rec, word);
+        data += n;
+        len -= n;
+    }
+}
+
+uint32_t log_arg_words(const char *value)
+{
+    if (platform_is_rom_pointer(value))
+    {
+        return 1;
+    }
+    else
+    {
+        return 1 + (strlen(value) + 3) / 4;
+    }
+}
+
+uint32_t log_arg_words(bytearray array)
+{
+    uint32_t len = (array.len > LOG_BYTEARRAY_MAX) ? LOG_BYTEARRAY_MAX : array.len;
+    return 1 + (len + 3) / 4;
+}
+
+void log_arg_put(log_record_t &rec, const char *value)
+{
+    if (platform_is_rom_pointer(value))
+    {
+        log_put_tag(rec, LOG_ARG_ROMSTR);
+        log_put_word(rec, (uint32_t)(uintptr_t)value);
+    }
+    else
+    {
+        uint32_t len = strlen(value);
+        log_put_tag(rec, LOG_ARG_STR);
+        log_put_word(rec, len);
+        log_put_bytes(rec, (const uint8_t*)value, len);
+    }
+}
+
+void log_arg_put(log_record_t &rec, uint8_t value)
+{
+    log_put_tag(rec, LOG_ARG_U8);
+    log_put_word(rec, value);
+}
+
+void log_arg_put(log_record_t &rec, uint32_t value)
+{
+    log_put_tag(rec, LOG_ARG_U32);
+    log_put_word(rec, value);
+}
+
+void log_arg_put(log_record_t &rec, uint64_t value)
+{
+    log_put_tag(rec, LOG_ARG_U64);
+    log_put_word(rec, (uint32_t)(value & 0xFFFFFFFF));
+    log_put_word(rec, (uint32_t)(value >> 32));
+}
+
+void log_arg_put(log_record_t &rec, int value)
+{
+    log_put_tag(rec, LOG_ARG_INT);
+    log_put_word(rec, (uint32_t)value);
+}
+
+void log_arg_put(log_record_t &rec, double value)
+{
+    uint32_t words[2];
+    memcpy(words, &value, sizeof(words));
+    log_put_tag(rec, LOG_ARG_DOUBLE);
+    log_put_word(rec, words[0]);
+    log_put_word(rec, words[1]);
+}
+
+void log_arg_put(log_record_t &rec, bool value)
+{
+    log_put_tag(rec, LOG_ARG_BOOL);
+    log_put_word(rec, value);
+}
+
+void log_arg_put(log_record_t &rec, bytearray array)
+{
+    uint32_t len = (array.len > LOG_BYTEARRAY_MAX) ? LOG_BYTEARRAY_MAX : array.len;
+    log_put_tag(rec, LOG_ARG_BYTES);
+    log_put_word(rec, array.len);
+    log_put_bytes(rec, array.data, len);
+}
+
+bool log_record_begin(log_record_t &rec, uint32_t flags, uint32_t nargs, uint32_t argwords)
+{
+    uint32_t tagwords = (nargs + 7) / 8;
+    uint32_t total = 2 + tagwords + argwords;
+    if (total > LOG_RECORD_MAX_WORDS || nargs > 255)
+    {
+        return false;
+    }
+
+    for (int retry = 0; retry < 2; retry++)
+    {
+        uint32_t status = platform_irq_save();
+        if (LOG_BINARY_WORDS - (g_logbinary.wrpos - g_logbinary.rdpos) >= total)
+        {
+            // Header stays zero until log_record_end() so that the
+            // formatter does not read a partially written record.
+            rec.start = g_logbinary.wrpos;
+            g_logbinary.wrpos += total;
+            g_logbinary.words[rec.start & LOGBINMASK] = 0;
+            platform_irq_restore(status);
+
+            rec.header = LOG_RECORD_MAGIC | (flags << 20) | (nargs << 12) | total;
+            rec.pos = rec.start + 1;
+            log_put_word(rec, millis());
+            rec.tagpos = rec.pos;
+            rec.argidx = 0;
+            for (uint32_t i = 0; i < tagwords; i++)
+            {
+                log_put_word(rec, 0);
+            }
+            return true;
+        }
+        platform_irq_restore(status);
+
+        // Ring is full, make space by formatting older records now
+        log_format_pending();
+    }
+
+    return false;
+}
+
+void log_record_end(log_record_t &rec)
+{
+    g_logbinary.words[rec.start & LOGBINMASK] = rec.header;
+}
+
+void log_raw_prefix(uint32_t flags, uint32_t timestamp)
+{
+    if (flags & LOG_RECORD_TIMESTAMP)
+    {
+        log_raw("[", (int)timestamp, "ms] ");
+    }
+
+    if (flags & LOG_RECORD_DEBUG)
+    {
+        log_raw("DBG ");
+    }
+}
+
+static inline uint32_t log_get_word(uint32_t &pos)
+{
+    return g_logbinary.words[pos++ & LOGBINMASK];
+}
+
+static void log_get_bytes(uint32_t &pos, uint8_t *dest, uint32_t len)
+{
+    while (len > 0)
+    {
+        uint32_t word = log_get_word(pos);
+        uint32_t n = (len > 4) ? 4 : len;
+        memcpy(dest, &word, n);
+        dest += n;
+        len -= n;
+    }
+}
+
+// Format one argument, returns false if tag is invalid
+static bool log_format_arg(uint32_t tag, uint32_t &pos)
+{
+    switch (tag)
+    {
+        case LOG_ARG_ROMSTR:
+            log_raw((const char*)(uintptr_t)log_get_word(pos));
+            return true;
+
+        case LOG_ARG_STR:
+        {
+            uint32_t len = log_get_word(pos);
+            while (len > 0)
+            {
+                char buf[33];
+                uint32_t n = (len > 32) ? 32 : len;
+                log_get_bytes(pos, (uint8_t*)buf, n);
+                buf[n] = '\0';
+                log_raw(buf);
+                len -= n;
+            }
+            return true;
+        }
+
+        case LOG_ARG_U8:
+            log_raw((uint8_t)log_get_word(pos));
+            return true;
+
+        case LOG_ARG_U32:
+            log_raw((uint32_t)log_get_word(pos));
+            return true;
+
+        case LOG_ARG_U64:
+        {
+            uint64_t low = log_get_word(pos);
+            uint64_t high = log_get_word(pos);
+            log_raw((uint64_t)(low | (high << 32)));
+            return true;
+        }
+
+        case LOG_ARG_INT:
+            log_raw((int)log_get_word(pos));
+            return true;
+
+        case LOG_ARG_DOUBLE:
+        {
+            uint32_t words[2];
+            double value;
+            words[0] = log_get_word(pos);
+            words[1] = log_get_word(pos);
+            memcpy(&value, words, sizeof(value));
+            log_raw(value);
+            return true;
+        }
+
+        case LOG_ARG_BOOL:
+            log_raw((bool)log_get_word(pos));
+            return true;
+
+        case LOG_ARG_BYTES:
+        {
+            uint8_t data[LOG_BYTEARRAY_MAX];
+            uint32_t total = log_get_word(pos);
+            uint32_t len = (total > LOG_BYTEARRAY_MAX) ? LOG_BYTEARRAY_MAX : total;
+            log_get_bytes(pos, data, len);
+            log_bytes(data, len, total);
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
+
+void log_format_pending()
+{
+    if (g_logbinary.formatting)
+    {
+        return;
+    }
+
+    g_logbinary.formatting = true;
+    while (g_logbinary.rdpos != g_logbinary.wrpos)
+    {
+        uint32_t pos = g_logbinary.rdpos;
+        uint32_t header = log_get_word(pos);
+        if ((header & 0xFF000000) != LOG_RECORD_MAGIC)
+        {
+            // Record is still being written
+            break;
+        }
+
+        uint32_t total = header & 0xFFF;
+        uint32_t nargs = (header >> 12) & 0xFF;
+        uint32_t flags = (header >> 20) & 0xF;
+        uint32_t timestamp = log_get_word(pos);
+        uint32_t tagpos = pos;
+        pos += (nargs + 7) / 8;
+
+        log_raw_prefix(flags, timestamp);
+        for (uint32_t i = 0; i < nargs; i++)
+        {
+            uint32_t tag = (g_logbinary.words[(tagpos + i / 8) & LOGBINMASK] >> (4 * (i % 8))) & 0xF;
+            if (!log_format_arg(tag, pos))
+            {
+                log_raw("<bad log record>");
+                break;
+            }
+        }
+        log_raw("\n");
+
+        g_logbinary.rdpos += total;
+    }
+    g_logbinary.formatting = false;
+}
+
 uint32_t log_get_buffer_len()
 {
+    log_format_pending();
     return g_logpos;
 }
 
 const char *log_get_buffer(uint32_t *startpos, uint32_t *available)
 {
+    log_format_pending();
+
     uint32_t default_pos = 0;
     if (startpos == NULL)
     {
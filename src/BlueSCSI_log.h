@@ -20,6 +20,10 @@ const char *log_get_buffer(uint32_t *startpos, uint32_t *available = nullptr);
 extern "C" bool g_log_debug;
 extern "C" uint8_t g_scsi_log_mask;
 
+// Format log() messages when called instead of deferring them.
+// Set during boot so that UART output is not lost if the firmware hangs.
+extern bool g_log_immediate;
+
 // Enables output test mode
 extern bool g_test_mode;
 
@@ -81,16 +85,106 @@ inline void log_raw(T first, T2 second, Rest... rest)
     log_raw(rest...);
 }
 
-// Format a complete log message
+// Deferred binary logging
+//
+// log() and debuglog() do not format text when called. Instead they store a
+// binary record with the timestamp, a type tag for each argument and the raw
+// argument values into a separate ring buffer. String literals are stored as
+// pointers, other strings and byte arrays are copied. The records are formatted
+// into the text log buffer when it is read by log_get_buffer(), i.e. when saving
+// log.txt or streaming to USB, so debug logging does not change SCSI timing.
+//
+// Messages that do not fit in a binary record are formatted immediately,
+// as are all messages while g_log_immediate is set.
+
+#define LOG_RECORD_TIMESTAMP 0x01
+#define LOG_RECORD_DEBUG     0x02
+
+struct log_record_t {
+    uint32_t start;   // Position of record header
+    uint32_t header;  // Header value written when record is complete
+    uint32_t pos;     // Next word to write
+    uint32_t tagpos;  // First argument tag word
+    uint32_t argidx;  // Index of next argument
+};
+
+// Number of 32-bit words needed to store each argument type.
+// The overloads must match log_raw() so that the same conversions apply.
+uint32_t log_arg_words(const char *value);
+inline uint32_t log_arg_words(uint8_t value) { return 1; }
+inline uint32_t log_arg_words(uint32_t value) { return 1; }
+inline uint32_t log_arg_words(uint64_t value) { return 2; }
+inline uint32_t log_arg_words(int value) { return 1; }
+inline uint32_t log_arg_words(double value) { return 2; }
+inline uint32_t log_arg_words(bool value) { return 1; }
+uint32_t log_arg_words(bytearray array);
+
+// Store argument to binary record
+void log_arg_put(log_record_t &rec, const char *value);
+void log_arg_put(log_record_t &rec, uint8_t value);
+void log_arg_put(log_record_t &rec, uint32_t value);
+void log_arg_put(log_record_t &rec, uint64_t value);
+void log_arg_put(log_record_t &rec, int value);
+void log_arg_put(log_record_t &rec, double value);
+void log_arg_put(log_record_t &rec, bool value);
+void log_arg_put(log_record_t &rec, bytearray array);
+
+// Reserve space for a record, returns false if it does not fit
+bool log_record_begin(log_record_t &rec, uint32_t flags, uint32_t nargs, uint32_t argwords);
+
+// Publish the record for formatting
+void log_record_end(log_record_t &rec);
+
+// Format pending binary records into the text log buffer
+void log_format_pending();
+
+// Write timestamp and debug prefix of a message
+void log_raw_prefix(uint32_t flags, uint32_t timestamp);
+
+inline uint32_t log_args_words()
+{
+    return 0;
+}
+
+template<typename T, typename... Rest>
+inline uint32_t log_args_words(T first, Rest... rest)
+{
+    return log_arg_words(first) + log_args_words(rest...);
+}
+
+inline void log_args_put(log_record_t &rec)
+{
+}
+
+template<typename T, typename... Rest>
+inline void log_args_put(log_record_t &rec, T first, Rest... rest)
+{
+    log_arg_put(rec, first);
+    log_args_put(rec, rest...);
+}
+
 template<typename... Params>
-inline void log(Params... params)
+inline void log_deferred(uint32_t flags, Params... params)
 {
-    if (g_log_debug)
+    log_record_t rec;
+    if (!g_log_immediate && log_record_begin(rec, flags, sizeof...(params), log_args_words(params...)))
+    {
+        log_args_put(rec, params...);
+        log_record_end(rec);
+    }
+    else
     {
-        log_raw("[", (int)millis(), "ms] ");
+        log_raw_prefix(flags, millis());
+        log_raw(params...);
+        log_raw("\n");
     }
-    log_raw(params...);
-    log_raw("\n");
+}
+
+// Format a complete log message
+template<typename... Params>
+inline void log(Params... params)
+{
+    log_deferred(g_log_debug ? LOG_RECORD_TIMESTAMP : 0, params...);
 }
 
 // Format a complete debug message
@@ -104,9 +198,7 @@ inline void debuglog(Params... params)
         {
             return;
         }
-        log_raw("[", (int)millis(), "ms] DBG ");
-        log_raw(params...);
-        log_raw("\n");
+        log_deferred(LOG_RECORD_TIMESTAMP | LOG_RECORD_DEBUG, params...);
     }
 }
 
@@ -65,6 +65,8 @@ static const char *getCommandName(uint8_t cmd)
         case 0x44: return "CDROM Read Header";
         case 0x46: return "CDROM GetConfiguration";
         case 0x4A: return "GetEventStatusNotification";
+        case 0x4C: return "LogSelect";
+        case 0x4D: return "LogSense";
         case 0x4B: return "CDROM PauseResume";
         case 0x4E: return "CDROM StopPlayScan";
         case 0x51: return "CDROM ReadDiscInformation";
@@ -96,6 +98,7 @@ static const char *getCommandName(uint8_t cmd)
         case BLUESCSI_TOOLBOX_SET_NEXT_CD: return "BLUESCSI_TOOLBOX_SET_NEXT_CD";
         case BLUESCSI_TOOLBOX_LIST_DEVICES: return "BLUESCSI_TOOLBOX_LIST_DEVICES";
         case BLUESCSI_TOOLBOX_COUNT_CDS: return "BLUESCSI_TOOLBOX_COUNT_CDS";
+        case BLUESCSI_TOOLBOX_DUMP_TIMELINE: return "BLUESCSI_TOOLBOX_DUMP_TIMELINE";
         default:   return "Unknown";
     }
 }
@@ -0,0 +1,284 @@
+// Per-target, per-opcode command statistics served through LOG SENSE.
+
+#include "BlueSCSI_stats.h"
+#include "BlueSCSI_config.h"
+#include "BlueSCSI_log.h"
+#include "BlueSCSI_platform.h"
+#include <string.h>
+#include <scsi2sd.h>
+extern "C" {
+#include <scsi.h>
+}
+
+struct scsi_opcode_stats_t {
+    uint16_t opcode;
+    uint32_t count;
+    uint32_t cache_hits;
+    uint64_t bytes;
+    uint32_t latency[SCSI_STATS_BUCKETS];
+    uint32_t sd_time[SCSI_STATS_BUCKETS];
+};
+
+static struct {
+    scsi_opcode_stats_t targets[NUM_SCSIID][SCSI_STATS_SLOTS];
+
+    // State of command currently being processed
+    bool active;
+    uint8_t target;
+    uint8_t opcode;
+    uint8_t cache_hit;
+    uint32_t start_us;
+    uint32_t bytes;
+    uint32_t sd_us;
+} g_scsi_stats;
+
+static void clearTargetStats(int target)
+{
+    memset(g_scsi_stats.targets[target], 0, sizeof(g_scsi_stats.targets[target]));
+    for (int i = 0; i < SCSI_STATS_SLOTS; i++)
+    {
+        g_scsi_stats.targets[target][i].opcode = SCSI_STATS_UNUSED;
+    }
+}
+
+static scsi_opcode_stats_t *findSlot(int target, uint8_t opcode)
+{
+    scsi_opcode_stats_t *slots = g_scsi_stats.targets[target];
+    for (int i = 0; i < SCSI_STATS_SLOTS - 1; i++)
+    {
+        if (slots[i].opcode == opcode)
+        {
+            return &slots[i];
+        }
+        else if (slots[i].opcode == SCSI_STATS_UNUSED)
+        {
+            slots[i].opcode = opcode;
+            return &slots[i];
+        }
+    }
+
+    slots[SCSI_STATS_SLOTS - 1].opcode = SCSI_STATS_OTHER;
+    return &slots[SCSI_STATS_SLOTS - 1];
+}
+
+static inline int histogramBucket(uint32_t us)
+{
+    uint32_t v = us >> 2;
+    if (v == 0) return 0;
+    int bucket = 31 - __builtin_clz(v);
+    return (bucket < SCSI_STATS_BUCKETS - 1) ? bucket : SCSI_STATS_BUCKETS - 1;
+}
+
+extern "C" void scsiStatsCommandStart(uint8_t opcode)
+{
+    static bool initialized = false;
+    if (unlikely(!initialized))
+    {
+        for (int i = 0; i < NUM_SCSIID; i++)
+        {
+            clearTargetStats(i);
+        }
+        initialized = true;
+    }
+
+    g_scsi_stats.active = (scsiDev.target != NULL);
+    g_scsi_stats.target = scsiDev.target ? (scsiDev.target->targetId & S2S_CFG_TARGET_ID_BITS) : 0;
+    g_scsi_stats.opcode = opcode;
+    g_scsi_stats.cache_hit = 0;
+    g_scsi_stats.start_us = platform_time_us();
+    g_scsi_stats.bytes = 0;
+    g_scsi_stats.sd_us = 0;
+}
+
+extern "C" void scsiStatsCommandEnd()
+{
+    if (!g_scsi_stats.active) return;
+    g_scsi_stats.active = false;
+
+    uint32_t latency = platform_time_us() - g_scsi_stats.start_us;
+    scsi_opcode_stats_t *slot = findSlot(g_scsi_stats.target, g_scsi_stats.opcode);
+    slot->count++;
+    slot->cache_hits += g_scsi_stats.cache_hit;
+    slot->bytes += g_scsi_stats.bytes;
+    slot->latency[histogramBucket(latency)]++;
+
+    if (g_scsi_stats.sd_us > 0)
+    {
+        slot->sd_time[histogramBucket(g_scsi_stats.sd_us)]++;
+    }
+}
+
+extern "C" void scsiStatsDataBytes(uint32_t count)
+{
+    g_scsi_stats.bytes += count;
+}
+
+extern "C" void scsiStatsSdTime(uint32_t us)
+{
+    if (g_scsi_stats.active)
+    {
+        g_scsi_stats.sd_us += us;
+    }
+}
+
+extern "C" void scsiStatsCacheHit()
+{
+    g_scsi_stats.cache_hit = 1;
+}
+
+/*************************/
+/* LOG SENSE / LOG SELECT */
+/*************************/
+
+static uint8_t *putBE32(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+    return p + 4;
+}
+
+// Append parameters of a vendor page, returns page length
+static uint32_t buildStatsPage(uint8_t page, uint16_t paramPointer, uint8_t *out)
+{
+    uint8_t *p = out;
+    int target = scsiDev.target->targetId & S2S_CFG_TARGET_ID_BITS;
+    scsi_opcode_stats_t *slots = g_scsi_stats.targets[target];
+
+    // Slots are in allocation order but parameters must be sent in ascending
+    // parameter code order, SCSI_STATS_OTHER sorts after all opcodes.
+    uint32_t nextCode = paramPointer;
+    while (true)
+    {
+        scsi_opcode_stats_t *slot = NULL;
+        for (int i = 0; i < SCSI_STATS_SLOTS; i++)
+        {
+            if (slots[i].opcode != SCSI_STATS_UNUSED && slots[i].opcode >= nextCode &&
+                (slot == NULL || slots[i].opcode < slot->opcode))
+            {
+                slot = &slots[i];
+            }
+        }
+
+        if (slot == NULL)
+            break;
+        nextCode = slot->opcode + 1;
+
+        *p++ = slot->opcode >> 8;
+        *p++ = slot->opcode;
+        *p++ = 0x03; // Binary format list
+        if (page == SCSI_STATS_PAGE_COUNTERS)
+        {
+            *p++ = 16;
+            p = putBE32(p, slot->count);
+            p = putBE32(p, slot->cache_hits);
+            p = putBE32(p, (uint32_t)(slot->bytes >> 32));
+            p = putBE32(p, (uint32_t)slot->bytes);
+        }
+        else
+        {
+            const uint32_t *hist = (page == SCSI_STATS_PAGE_LATENCY) ? slot->latency : slot->sd_time;
+            *p++ = SCSI_STATS_BUCKETS * 4;
+            for (int j = 0; j < SCSI_STATS_BUCKETS; j++)
+            {
+                p = putBE32(p, hist[j]);
+            }
+        }
+    }
+
+    return p - out;
+}
+
+static void doLogSense()
+{
+    bool sp = scsiDev.cdb[1] & 0x01;
+    uint8_t page = scsiDev.cdb[2] & 0x3F;
+    uint16_t paramPointer = ((uint16_t)scsiDev.cdb[5] << 8) | scsiDev.cdb[6];
+    uint32_t allocLength = ((uint32_t)scsiDev.cdb[7] << 8) | scsiDev.cdb[8];
+
+    uint8_t *buf = scsiDev.data;
+    uint32_t len;
+    if (sp)
+    {
+        // Counters are kept in RAM only
+        len = 0;
+    }
+    else if (page == 0x00)
+    {
+        // Supported log pages
+        len = 0;
+        buf[4 + len++] = 0x00;
+        buf[4 + len++] = SCSI_STATS_PAGE_COUNTERS;
+        buf[4 + len++] = SCSI_STATS_PAGE_LATENCY;
+        buf[4 + len++] = SCSI_STATS_PAGE_SD_TIME;
+    }
+    else if (page == SCSI_STATS_PAGE_COUNTERS ||
+             page == SCSI_STATS_PAGE_LATENCY ||
+             page == SCSI_STATS_PAGE_SD_TIME)
+    {
+        len = buildStatsPage(page, paramPointer, buf + 4);
+    }
+    else
+    {
+        sp = true;
+        len = 0;
+    }
+
+    if (sp)
+    {
+        scsiDev.status = CHECK_CONDITION;
+        scsiDev.target->sense.code = ILLEGAL_REQUEST;
+        scsiDev.target->sense.asc = INVALID_FIELD_IN_CDB;
+        scsiDev.phase = STATUS;
+        return;
+    }
+
+    buf[0] = page;
+    buf[1] = 0;
+    buf[2] = len >> 8;
+    buf[3] = len;
+    len += 4;
+
+    scsiDev.dataLen = (len < allocLength) ? len : allocLength;
+    scsiDev.phase = DATA_IN;
+}
+
+static void doLogSelect()
+{
+    bool pcr = scsiDev.cdb[1] & 0x02;
+    uint16_t paramListLength = ((uint16_t)scsiDev.cdb[7] << 8) | scsiDev.cdb[8];
+
+    if (paramListLength > 0)
+    {
+        // Setting parameter values is not supported
+        scsiDev.status = CHECK_CONDITION;
+        scsiDev.target->sense.code = ILLEGAL_REQUEST;
+        scsiDev.target->sense.asc = INVALID_FIELD_IN_CDB;
+    }
+    else if (pcr)
+    {
+        int target = scsiDev.target->targetId & S2S_CFG_TARGET_ID_BITS;
+        debuglog("Clearing command statistics for target ", target);
+        clearTargetStats(target);
+    }
+
+    scsiDev.phase = STATUS;
+}
+
+extern "C" int scsiStatsCommand()
+{
+    uint8_t command = scsiDev.cdb[0];
+    if (unlikely(command == 0x4D))
+    {
+        doLogSense();
+        return 1;
+    }
+    else if (unlikely(command == 0x4C))
+    {
+        doLogSelect();
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,60 @@
+// Per-target, per-opcode command statistics.
+//
+// Counts commands, data bytes and prefetch cache hits, and keeps log2
+// histograms of command-to-status latency and SD card service time.
+// The statistics are served to the host through LOG SENSE vendor pages:
+//
+//   0x30  Command counters, 16 bytes per opcode:
+//         command count (4), cache hits (4), data bytes (8)
+//   0x31  Command-to-status latency histogram, SCSI_STATS_BUCKETS x 4 bytes
+//   0x32  SD card service time histogram, SCSI_STATS_BUCKETS x 4 bytes
+//
+// Parameter code is the opcode, or SCSI_STATS_OTHER for opcodes that did not
+// fit in the per-target table. Histogram bucket 0 counts durations below 8 us,
+// bucket N counts durations from 2^(N+2) to 2^(N+3) us and the last bucket
+// everything longer. LOG SELECT with PCR bit set clears the target counters.
+//
+// Updates are a few additions per command, so statistics are always enabled.
+
+#pragma once
+
+#include <stdint.h>
+
+// Number of distinct opcodes tracked per target, last slot collects the rest
+#ifndef SCSI_STATS_SLOTS
+#define SCSI_STATS_SLOTS 8
+#endif
+
+#define SCSI_STATS_BUCKETS 16
+#define SCSI_STATS_OTHER 0x100
+#define SCSI_STATS_UNUSED 0xFFFF
+
+#define SCSI_STATS_PAGE_COUNTERS  0x30
+#define SCSI_STATS_PAGE_LATENCY   0x31
+#define SCSI_STATS_PAGE_SD_TIME   0x32
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Called from scsiPhy.cpp when a CDB has been received
+void scsiStatsCommandStart(uint8_t opcode);
+
+// Called from scsiPhy.cpp when entering STATUS phase
+void scsiStatsCommandEnd();
+
+// Data phase bytes transferred for current command
+void scsiStatsDataBytes(uint32_t count);
+
+// Time spent in a single SD card transfer
+void scsiStatsSdTime(uint32_t us);
+
+// Part of the current command was served from prefetch buffer
+void scsiStatsCacheHit();
+
+// LOG SENSE / LOG SELECT handler, returns 1 if command was handled
+int scsiStatsCommand();
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,95 @@
+// Binary timeline of SCSI bus and SD card events.
+
+#include "BlueSCSI_timeline.h"
+#include "BlueSCSI_config.h"
+#include "BlueSCSI_log.h"
+#include "BlueSCSI_platform.h"
+#include <SdFat.h>
+#include <scsi2sd.h>
+extern "C" {
+#include <scsi.h>
+}
+
+#define TIMELINE_MASK (TIMELINE_ENTRY_COUNT - 1)
+
+extern SdFs SD;
+
+bool g_timeline_enabled;
+volatile bool g_timeline_dump_requested;
+
+static struct {
+    timeline_entry_t entries[TIMELINE_ENTRY_COUNT];
+    uint32_t pos; // Total number of events recorded since clear
+} g_timeline;
+
+void timeline_record_event(uint8_t event, uint16_t arg16, uint32_t arg32)
+{
+    // Selection and DMA events are recorded from interrupt handlers,
+    // so the slot is reserved with interrupts disabled.
+    uint32_t status = platform_irq_save();
+    timeline_entry_t *entry = &g_timeline.entries[g_timeline.pos & TIMELINE_MASK];
+    g_timeline.pos++;
+    entry->timestamp_us = platform_time_us();
+    entry->event = event;
+    entry->target = scsiDev.target ? scsiDev.target->targetId : 0xFF;
+    entry->arg16 = arg16;
+    entry->arg32 = arg32;
+    platform_irq_restore(status);
+}
+
+void timeline_clear()
+{
+    uint32_t status = platform_irq_save();
+    g_timeline.pos = 0;
+    platform_irq_restore(status);
+}
+
+bool timeline_save()
+{
+    // Stop recording while the buffer is being written out,
+    // otherwise our own SD accesses would overwrite the oldest entries.
+    bool was_enabled = g_timeline_enabled;
+    g_timeline_enabled = false;
+    g_timeline_dump_requested = false;
+
+    uint32_t pos = g_timeline.pos;
+    uint32_t count = (pos > TIMELINE_ENTRY_COUNT) ? TIMELINE_ENTRY_COUNT : pos;
+    uint32_t first = pos - count;
+
+    timeline_file_header_t header = {};
+    header.magic = TIMELINE_FILE_MAGIC;
+    header.version = TIMELINE_FILE_VERSION;
+    header.entry_size = sizeof(timeline_entry_t);
+    header.entry_count = count;
+    header.dropped = first;
+
+    bool ok = false;
+    FsFile file = SD.open(TIMELINEFILE, O_WRONLY | O_CREAT | O_TRUNC);
+    if (file.isOpen())
+    {
+        ok = (file.write(&header, sizeof(header)) == sizeof(header));
+
+        // Ring may wrap, write in at most two contiguous pieces
+        uint32_t start = first & TIMELINE_MASK;
+        uint32_t part1 = TIMELINE_ENTRY_COUNT - start;
+        if (part1 > count) part1 = count;
+        uint32_t part2 = count - part1;
+
+        ok = ok && file.write(&g_timeline.entries[start], part1 * sizeof(timeline_entry_t)) == part1 * sizeof(timeline_entry_t);
+        ok = ok && file.write(&g_timeline.entries[0], part2 * sizeof(timeline_entry_t)) == part2 * sizeof(timeline_entry_t);
+        file.close();
+    }
+
+    if (ok)
+    {
+        log("Saved ", (int)count, " timeline events to " TIMELINEFILE ", ", (int)first, " older events were dropped");
+    }
+    else
+    {
+        log("Failed to write " TIMELINEFILE ": ", (int)SD.sdErrorCode());
+    }
+
+    timeline_clear();
+    g_timeline_enabled = was_enabled;
+    return ok;
+}
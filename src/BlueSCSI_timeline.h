@@ -0,0 +1,81 @@
+// Binary timeline of SCSI bus and SD card events.
+//
+// Events are recorded into a fixed-size RAM ring buffer with microsecond
+// timestamps. Recording only takes a few cycles, so it can be used to analyze
+// timing problems that disappear when text logging is enabled.
+// The buffer is dumped to TIMELINEFILE on request and can be converted to
+// Chrome / Perfetto trace format with utils/timeline_to_perfetto.py.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Number of events kept in RAM, must be a power of 2
+#ifndef TIMELINE_ENTRY_COUNT
+#define TIMELINE_ENTRY_COUNT 512
+#endif
+
+#define TIMELINE_FILE_MAGIC 0x4C545342 // "BSTL"
+#define TIMELINE_FILE_VERSION 1
+
+enum timeline_event_t {
+    TIMELINE_EVT_NONE      = 0,
+    TIMELINE_EVT_SELECTION = 1, // arg16: selected id, arg32: status flags
+    TIMELINE_EVT_COMMAND   = 2, // arg16: opcode, arg32: cdb bytes 2..5 (LBA for most commands)
+    TIMELINE_EVT_PHASE     = 3, // arg16: new phase (BUS_FREE = 0xFFFF)
+    TIMELINE_EVT_DMA_START = 4, // arg16: 0 = to host, 1 = from host, arg32: byte count
+    TIMELINE_EVT_DMA_STOP  = 5, // arg16: 0 = to host, 1 = from host
+    TIMELINE_EVT_SD_START  = 6, // arg16: 0 = read, 1 = write, arg32: first sector
+    TIMELINE_EVT_SD_END    = 7, // arg16: 0 = read, 1 = write, arg32: sector count
+};
+
+// Single record as stored in RAM and in TIMELINEFILE
+struct timeline_entry_t {
+    uint32_t timestamp_us;
+    uint8_t event;
+    uint8_t target;  // SCSI id of current target, 0xFF if none
+    uint16_t arg16;
+    uint32_t arg32;
+};
+
+// Header of TIMELINEFILE, followed by entries in chronological order
+struct timeline_file_header_t {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entry_size;
+    uint32_t entry_count;
+    uint32_t dropped;  // Events overwritten before the dump
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Set by [SCSI] Timeline=1 in the ini file
+extern bool g_timeline_enabled;
+
+// Set by toolbox command, serviced from main loop when bus is free
+extern volatile bool g_timeline_dump_requested;
+
+void timeline_record_event(uint8_t event, uint16_t arg16, uint32_t arg32);
+
+// Cheap enough to call from interrupt handlers and data transfer paths
+static inline void timeline_record(uint8_t event, uint16_t arg16, uint32_t arg32)
+{
+    if (g_timeline_enabled)
+    {
+        timeline_record_event(event, arg16, arg32);
+    }
+}
+
+// Clear the ring buffer
+void timeline_clear();
+
+#ifdef __cplusplus
+}
+
+// Write the ring buffer contents to TIMELINEFILE and clear it.
+// Returns false if file could not be written.
+bool timeline_save();
+#endif
@@ -0,0 +1,135 @@
+#!/usr/bin/python3
+
+'''Converts timeline.bin saved by BlueSCSI firmware to Chrome trace event JSON.
+The result can be opened in https://ui.perfetto.dev or chrome://tracing
+
+Usage: timeline_to_perfetto.py timeline.bin [output.json]
+
+Enable recording with Timeline=1 in the [SCSI] section of bluescsi.ini and
+request a dump with toolbox command 0xDB.'''
+
+import sys
+import json
+import struct
+
+HEADER = struct.Struct('<IHHII')
+ENTRY = struct.Struct('<IBBHI')
+MAGIC = 0x4C545342
+
+EVT_SELECTION = 1
+EVT_COMMAND = 2
+EVT_PHASE = 3
+EVT_DMA_START = 4
+EVT_DMA_STOP = 5
+EVT_SD_START = 6
+EVT_SD_END = 7
+
+PHASES = {
+    0xFFFF: "BUS_FREE",
+    0: "DATA_OUT",
+    2: "COMMAND",
+    3: "MESSAGE_OUT",
+    4: "DATA_IN",
+    6: "STATUS",
+    7: "MESSAGE_IN",
+}
+
+# Track ids inside the single BlueSCSI process
+TID_BUS = 1
+TID_DMA = 2
+TID_SD = 3
+
+def read_timeline(path):
+    data = open(path, 'rb').read()
+    magic, version, entry_size, count, dropped = HEADER.unpack_from(data, 0)
+    if magic != MAGIC:
+        raise ValueError("%s is not a BlueSCSI timeline file" % path)
+    if version != 1 or entry_size != ENTRY.size:
+        raise ValueError("Unsupported timeline version %d, entry size %d" % (version, entry_size))
+
+    entries = []
+    offset = HEADER.size
+    prev_raw = None
+    time_us = 0
+    for i in range(count):
+        raw, event, target, arg16, arg32 = ENTRY.unpack_from(data, offset)
+        offset += ENTRY.size
+
+        # Hardware timer is 32 bits and wraps every 71 minutes
+        if prev_raw is not None:
+            time_us += (raw - prev_raw) & 0xFFFFFFFF
+        prev_raw = raw
+        entries.append((time_us, event, target, arg16, arg32))
+
+    return entries, dropped
+
+def convert(entries):
+    events = []
+
+    def meta(tid, name):
+        events.append({"ph": "M", "pid": 0, "tid": tid, "name": "thread_name", "args": {"name": name}})
+
+    events.append({"ph": "M", "pid": 0, "name": "process_name", "args": {"name": "BlueSCSI"}})
+    meta(TID_BUS, "SCSI bus phase")
+    meta(TID_DMA, "SCSI DMA")
+    meta(TID_SD, "SD card")
+
+    phase = None
+    dma_open = False
+    sd_open = None
+
+    def close_phase(ts):
+        if phase is not None and phase[1] != 0xFFFF:
+            events.append({"ph": "X", "pid": 0, "tid": TID_BUS, "ts": phase[0], "dur": ts - phase[0],
+                           "name": PHASES.get(phase[1], "PHASE_%d" % phase[1]),
+                           "args": {"target": phase[2]}})
+
+    for ts, event, target, arg16, arg32 in entries:
+        if event == EVT_PHASE:
+            close_phase(ts)
+            phase = (ts, arg16, target)
+        elif event == EVT_SELECTION:
+            events.append({"ph": "i", "s": "t", "pid": 0, "tid": TID_BUS, "ts": ts,
+                           "name": "Selection ID %d" % arg16, "args": {"bus": "0x%02x" % (arg32 & 0xFF)}})
+        elif event == EVT_COMMAND:
+            events.append({"ph": "i", "s": "t", "pid": 0, "tid": TID_BUS, "ts": ts,
+                           "name": "CDB 0x%02x" % arg16,
+                           "args": {"target": target, "cdb[2..5]": "0x%08x" % arg32}})
+        elif event == EVT_DMA_START:
+            if not dma_open:
+                events.append({"ph": "B", "pid": 0, "tid": TID_DMA, "ts": ts,
+                               "name": "DMA " + ("from host" if arg16 else "to host")})
+                dma_open = True
+            events.append({"ph": "i", "s": "t", "pid": 0, "tid": TID_DMA, "ts": ts,
+                           "name": "buffer", "args": {"bytes": arg32}})
+        elif event == EVT_DMA_STOP:
+            if dma_open:
+                events.append({"ph": "E", "pid": 0, "tid": TID_DMA, "ts": ts})
+                dma_open = False
+        elif event == EVT_SD_START:
+            if sd_open is not None:
+                # Previous command failed before completion
+                events.append({"ph": "E", "pid": 0, "tid": TID_SD, "ts": ts})
+            events.append({"ph": "B", "pid": 0, "tid": TID_SD, "ts": ts,
+                           "name": "SD " + ("write" if arg16 else "read"),
+                           "args": {"sector": arg32}})
+            sd_open = ts
+        elif event == EVT_SD_END:
+            if sd_open is not None:
+                events.append({"ph": "E", "pid": 0, "tid": TID_SD, "ts": ts, "args": {"sectors": arg32}})
+                sd_open = None
+
+    if entries:
+        close_phase(entries[-1][0])
+
+    return events
+
+if __name__ == '__main__':
+    if len(sys.argv) < 2:
+        print(__doc__)
+        sys.exit(1)
+
+    entries, dropped = read_timeline(sys.argv[1])
+    output = sys.argv[2] if len(sys.argv) > 2 else sys.argv[1].rsplit('.', 1)[0] + '.json'
+    json.dump({"traceEvents": convert(entries), "displayTimeUnit": "ns"}, open(output, 'w'), indent=1)
+    print("Converted %d events to %s (%d older events were dropped by firmware)" % (len(entries), output, dropped))